@@ -0,0 +1,162 @@
+/* bench/bench.c - Headless benchmarks (`make bench`)
+ *
+ * Each section drives the real module code without a compositor or a
+ * running Hyprland, and prints its timings to stdout.  bench_hyprland.c
+ * and bench_render.c include their module's source whole, so its static
+ * functions are reachable.  The modules' own logging goes to stderr,
+ * which is silenced unless -v is given.  Sections time through
+ * bench_run_samples(), so every row is a warmed-up best and mean.
+ *
+ * Usage: snappy-bench [-v] [section...]   (default: every section)
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "bench.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct {
+  const char *name;
+  void (*run)(void);
+  const char *what;
+} BenchSection;
+
+static const BenchSection sections[] = {
+    {"parse", bench_parse, "j/clients parsing: json-c vs in-place scanner"},
+    {"resync", bench_resync, "resync over a mock socket: sequential vs batch"},
+    {"aggregate", bench_aggregate, "context-mode grouping, 100-2000 windows"},
+    {"snapshot", bench_snapshot, "window list snapshots and model updates"},
+    {"raster", bench_raster, "card grid rasterization vs raster threads"},
+    {"startup", bench_startup_icons, "first frame, cold vs warm icon cache"},
+    {"icons", bench_icon_cache, "icon cache lookups: hash table vs array"},
+};
+
+#define SECTION_COUNT (int)(sizeof(sections) / sizeof(sections[0]))
+
+double bench_now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+void bench_report(const char *label, const double *ms, int runs) {
+  double best = ms[0], sum = 0;
+  for (int i = 0; i < runs; i++) {
+    if (ms[i] < best)
+      best = ms[i];
+    sum += ms[i];
+  }
+  /* Sub-millisecond results read better in microseconds */
+  double unit = best < 1 ? 1e3 : 1;
+  const char *name = best < 1 ? "us" : "ms";
+  printf("  %-28s best %9.3f %s   mean %9.3f %s\n", label, best * unit, name,
+         sum / runs * unit, name);
+}
+
+bool bench_run_samples(double (*sample)(void *), void *ctx,
+                       const char *label) {
+  double ms[BENCH_SAMPLES];
+  bool ok = sample(ctx) >= 0; /* Warm up */
+  for (int i = 0; i < BENCH_SAMPLES && ok; i++) {
+    ms[i] = sample(ctx);
+    ok = ms[i] >= 0;
+  }
+  if (ok)
+    bench_report(label, ms, BENCH_SAMPLES);
+  else
+    printf("  %-28s failed\n", label);
+  return ok;
+}
+
+static struct {
+  char dir[64];
+  char file[128];
+  char *saved; /* The caller's XDG_CACHE_HOME, NULL if unset */
+} cache_dir;
+
+static bool bench_cache_dir_create(void) {
+  snprintf(cache_dir.dir, sizeof(cache_dir.dir), "/tmp/snappy-bench-XXXXXX");
+  if (!mkdtemp(cache_dir.dir))
+    return false;
+  snprintf(cache_dir.file, sizeof(cache_dir.file),
+           "%s/snappy-switcher/icons.bin", cache_dir.dir);
+  const char *old = getenv("XDG_CACHE_HOME");
+  cache_dir.saved = old ? strdup(old) : NULL;
+  setenv("XDG_CACHE_HOME", cache_dir.dir, 1);
+  return true;
+}
+
+const char *bench_cache_file(void) { return cache_dir.file; }
+
+static void bench_cache_dir_remove(void) {
+  char path[160];
+  unlink(cache_dir.file);
+  snprintf(path, sizeof(path), "%s/snappy-switcher", cache_dir.dir);
+  rmdir(path);
+  rmdir(cache_dir.dir);
+  if (cache_dir.saved)
+    setenv("XDG_CACHE_HOME", cache_dir.saved, 1);
+  else
+    unsetenv("XDG_CACHE_HOME");
+  free(cache_dir.saved);
+  cache_dir.saved = NULL;
+}
+
+Config *bench_config_create(void) {
+  Config *config = get_default_config();
+  if (!config || !bench_cache_dir_create()) {
+    printf("  could not set up the default config and a cache directory\n");
+    free_config(config);
+    return NULL;
+  }
+  return config;
+}
+
+void bench_config_free(Config *config) {
+  free_config(config);
+  bench_cache_dir_remove();
+}
+
+static void usage(void) {
+  printf("Usage: snappy-bench [-v] [section...]\n\nSections:\n");
+  for (int i = 0; i < SECTION_COUNT; i++)
+    printf("  %-10s %s\n", sections[i].name, sections[i].what);
+}
+
+int main(int argc, char **argv) {
+  bool verbose = false;
+  int first = 1;
+  if (argc > 1 && strcmp(argv[1], "-v") == 0) {
+    verbose = true;
+    first = 2;
+  }
+  for (int a = first; a < argc; a++) {
+    bool known = false;
+    for (int i = 0; i < SECTION_COUNT; i++)
+      known |= strcmp(argv[a], sections[i].name) == 0;
+    if (!known) {
+      usage();
+      return 1;
+    }
+  }
+
+  if (!verbose && !freopen("/dev/null", "w", stderr))
+    return 1;
+
+  for (int i = 0; i < SECTION_COUNT; i++) {
+    bool run = first == argc;
+    for (int a = first; a < argc; a++)
+      run |= strcmp(argv[a], sections[i].name) == 0;
+    if (!run)
+      continue;
+    printf("== %s: %s ==\n", sections[i].name, sections[i].what);
+    fflush(stdout);
+    sections[i].run();
+    printf("\n");
+  }
+  return 0;
+}
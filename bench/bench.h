@@ -0,0 +1,60 @@
+/* bench/bench.h - Headless benchmarks (`make bench`) */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "../src/config.h"
+#include <stdbool.h>
+
+#define BENCH_SAMPLES 10 /* Timed samples per result row */
+
+/* Milliseconds on the monotonic clock */
+double bench_now_ms(void);
+
+/* Print one result row: a label and the best / mean of `runs` timings */
+void bench_report(const char *label, const double *ms, int runs);
+
+/* Call `sample` once to warm up, then BENCH_SAMPLES times, and report
+ * the ms each call returned under `label`.  A negative return is a
+ * failure: the row says so and false is returned. */
+bool bench_run_samples(double (*sample)(void *), void *ctx,
+                       const char *label);
+
+/* The default config, with XDG_CACHE_HOME pointing at a new private
+ * directory so the icon disk cache neither reads nor rewrites the user's.
+ * Prints why and returns NULL on failure. */
+Config *bench_config_create(void);
+
+/* Free it, delete the directory and restore XDG_CACHE_HOME */
+void bench_config_free(Config *config);
+
+/* The icon disk cache file inside the private directory */
+const char *bench_cache_file(void);
+
+/* j/clients parsing, json-c vs the in-place scanner, at 10/100/1000
+ * windows */
+void bench_parse(void);
+
+/* Resync against a mock Hyprland socket: two sequential requests vs one
+ * [[BATCH]] request */
+void bench_resync(void);
+
+/* Context-mode grouping of 100 to 2000 windows: hash table vs the old
+ * linear scan */
+void bench_aggregate(void);
+
+/* Window list snapshots from the maintained MRU / linear indices vs a
+ * qsort(), and the cost of the events that maintain them */
+void bench_snapshot(void);
+
+/* Card grid rasterization at scale 2 with 1, 2, 4 and 8 threads */
+void bench_raster(void);
+
+/* Startup to the first (and first complete) grid frame, with an empty vs
+ * a populated icon disk cache */
+void bench_startup_icons(void);
+
+/* Icon cache lookups with 48 to 1024 classes cached: hash table vs the
+ * old 256-entry array, and the cost of resolving an uncached class */
+void bench_icon_cache(void);
+
+#endif /* BENCH_H */
@@ -0,0 +1,697 @@
+/* bench/bench_hyprland.c - Hyprland IPC benchmarks
+ *
+ * Includes src/hyprland.c whole so the scanner and window model can be
+ * driven directly, on canned replies instead of a running Hyprland.
+ */
+#include "../src/hyprland.c"
+
+#include "bench.h"
+#include <json-c/json.h>
+#include <pthread.h>
+
+static const char *bench_client_classes[] = {
+    "firefox", "kitty", "code", "org.gnome.Nautilus", "mpv", "discord",
+    "obsidian", "thunderbird", "gimp", "Slack", "steam", "org.kde.okular",
+};
+
+#define BENCH_CLIENT_CLASS_COUNT                                               \
+  (int)(sizeof(bench_client_classes) / sizeof(bench_client_classes[0]))
+
+/*
+ * A j/clients reply for `count` windows, laid out as Hyprland prints it
+ * (every field, 4-space indents, "},{" between objects).  Titles carry
+ * escapes and non-ASCII text; every 20th window sits on a special
+ * workspace.  Returns a malloc'd string; *len excludes the NUL.
+ */
+static char *bench_clients_json(int count, size_t *len) {
+  size_t cap = 64 + (size_t)count * 1024;
+  char *buf = malloc(cap);
+  if (!buf)
+    return NULL;
+
+  size_t n = 0;
+  buf[n++] = '[';
+  for (int i = 0; i < count; i++) {
+    const char *cls = bench_client_classes[i % BENCH_CLIENT_CLASS_COUNT];
+    bool special = i % 20 == 19;
+    int ws = special ? -98 : 1 + i % 9;
+    char ws_name[32];
+    if (special)
+      snprintf(ws_name, sizeof(ws_name), "special:scratchpad");
+    else
+      snprintf(ws_name, sizeof(ws_name), "%d", ws);
+
+    n += snprintf(
+        buf + n, cap - n,
+        "%s{\n"
+        "    \"address\": \"0x%" PRIx64 "\",\n"
+        "    \"mapped\": true,\n"
+        "    \"hidden\": false,\n"
+        "    \"at\": [%d, %d],\n"
+        "    \"size\": [1264, 1374],\n"
+        "    \"workspace\": {\n"
+        "        \"id\": %d,\n"
+        "        \"name\": \"%s\"\n"
+        "    },\n"
+        "    \"floating\": %s,\n"
+        "    \"pseudo\": false,\n"
+        "    \"monitor\": 0,\n"
+        "    \"class\": \"%s\",\n"
+        "    \"title\": \"Document %d \\u2014 \\\"draft\\\" (~/notes/%s)\",\n"
+        "    \"initialClass\": \"%s\",\n"
+        "    \"initialTitle\": \"%s\",\n"
+        "    \"pid\": %d,\n"
+        "    \"xwayland\": false,\n"
+        "    \"pinned\": false,\n"
+        "    \"fullscreen\": 0,\n"
+        "    \"fullscreenClient\": 0,\n"
+        "    \"grouped\": [],\n"
+        "    \"tags\": [],\n"
+        "    \"swallowing\": \"0x0\",\n"
+        "    \"focusHistoryID\": %d,\n"
+        "    \"inhibitingIdle\": false,\n"
+        "    \"xdgTag\": \"\",\n"
+        "    \"xdgDescription\": \"\"\n"
+        "}",
+        i ? "," : "", (uint64_t)0x55d0c5a10000 + (uint64_t)i * 0x1d0,
+        12 + i % 2 * 1276, 56, ws, ws_name, i % 7 == 6 ? "true" : "false",
+        cls, i, cls, cls, cls, 2000 + i, count - 1 - i);
+  }
+  buf[n++] = ']';
+  buf[n] = '\0';
+  *len = n;
+  return buf;
+}
+
+/* String copy for the old code below, tolerating a NULL input */
+static char *bench_strdup(const char *str) { return strdup(str ? str : ""); }
+
+/* What parse_clients() did before the scanner: a json-c tree, then each
+ * field looked up by name and copied into `state` */
+static int bench_parse_jsonc(const char *json_str, AppState *state) {
+  struct json_object *root = json_tokener_parse(json_str);
+  if (!root || !json_object_is_type(root, json_type_array)) {
+    if (root)
+      json_object_put(root);
+    return -1;
+  }
+
+  size_t len = json_object_array_length(root);
+  for (size_t i = 0; i < len; i++) {
+    struct json_object *obj = json_object_array_get_idx(root, i);
+    struct json_object *ws_obj = NULL, *ws_id = NULL, *ws_name = NULL,
+                       *addr = NULL, *title = NULL, *cls = NULL,
+                       *focus = NULL, *floating = NULL;
+
+    if (!json_object_object_get_ex(obj, "workspace", &ws_obj))
+      continue;
+    if (!json_object_object_get_ex(ws_obj, "id", &ws_id))
+      continue;
+
+    int wid = json_object_get_int(ws_id);
+    if (wid == -1)
+      continue;
+
+    json_object_object_get_ex(ws_obj, "name", &ws_name);
+    json_object_object_get_ex(obj, "address", &addr);
+    json_object_object_get_ex(obj, "title", &title);
+    json_object_object_get_ex(obj, "class", &cls);
+    json_object_object_get_ex(obj, "focusHistoryID", &focus);
+    json_object_object_get_ex(obj, "floating", &floating);
+
+    WindowInfo info = {0};
+    info.id = parse_address(json_object_get_string(addr));
+    info.title = bench_strdup(json_object_get_string(title));
+    info.class_name = bench_strdup(json_object_get_string(cls));
+    info.workspace_id = wid;
+    info.workspace_name =
+        bench_strdup(ws_name ? json_object_get_string(ws_name) : "");
+    info.focus_history_id = focus ? json_object_get_int(focus) : 9999;
+    info.is_active = (info.focus_history_id == 0);
+    info.is_floating = floating ? json_object_get_boolean(floating) : false;
+    info.group_count = 1;
+    info.member_offset = -1;
+    app_state_add(state, &info);
+  }
+
+  json_object_put(root);
+  return 0;
+}
+
+/* The json-c path owned one heap copy per string */
+static void bench_jsonc_state_free(AppState *state) {
+  for (int i = 0; i < state->count; i++) {
+    free(state->windows[i].title);
+    free(state->windows[i].class_name);
+    free(state->windows[i].workspace_name);
+  }
+  app_state_free(state);
+}
+
+typedef enum { PARSE_JSONC, PARSE_SCANNER, PARSE_SNAPSHOT } ParseMode;
+
+typedef struct {
+  ParseMode mode;
+  const char *json;
+  size_t len;
+  int reps;
+} ParseSample;
+
+/* Time `reps` parses of `json` (a fresh copy each, made outside the
+ * timing as the scanner decodes in place); returns ms per parse */
+static double bench_parse_sample(void *ctx) {
+  const ParseSample *p = ctx;
+  char *copy = malloc(p->len + 1);
+  if (!copy)
+    return -1;
+
+  double total = 0;
+  for (int r = 0; r < p->reps; r++) {
+    memcpy(copy, p->json, p->len + 1);
+    double t0 = bench_now_ms();
+    if (p->mode == PARSE_JSONC) {
+      AppState state;
+      app_state_init(&state);
+      bench_parse_jsonc(copy, &state);
+      bench_jsonc_state_free(&state);
+    } else {
+      JsonScan s = {copy, copy + p->len};
+      parse_clients(&s);
+      if (p->mode == PARSE_SNAPSHOT) {
+        AppState state;
+        app_state_init(&state);
+        model.synced = true; /* No resync: the model is current */
+        update_window_list(&state, NULL, false);
+        app_state_free(&state);
+      }
+    }
+    total += bench_now_ms() - t0;
+  }
+  free(copy);
+  model_clear();
+  return total / p->reps;
+}
+
+void bench_parse(void) {
+  static const int counts[] = {10, 100, 1000};
+  static const struct {
+    ParseMode mode;
+    const char *name;
+  } modes[] = {
+      {PARSE_JSONC, "json-c tree"},
+      {PARSE_SCANNER, "in-place scanner"},
+      {PARSE_SNAPSHOT, "scanner + snapshot"},
+  };
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    size_t len;
+    char *json = bench_clients_json(counts[c], &len);
+    if (!json) {
+      printf("  out of memory\n");
+      return;
+    }
+    int reps = 20000 / counts[c];
+    printf("  %d windows (%zu bytes), %d parses per sample\n", counts[c],
+           len, reps);
+
+    for (size_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+      ParseSample p = {modes[m].mode, json, len, reps};
+      bench_run_samples(bench_parse_sample, &p, modes[m].name);
+    }
+    free(json);
+  }
+}
+
+/* --- Batched vs sequential resync ---
+ *
+ * A mock .socket.sock served by a thread: one request per connection,
+ * replies built from the canned fixtures, [[BATCH]] commands answered
+ * part by part with Hyprland's "\n\n\n" separator.  Hyprland answers IPC
+ * from its event loop, so each request can be given an extra delay to
+ * model a compositor that is busy drawing when it arrives.
+ */
+
+#define BENCH_RESYNC_WINDOWS 100
+#define BENCH_RESYNC_ROUNDS 50
+
+static const char bench_active_ws_json[] =
+    "{\n"
+    "    \"id\": 3,\n"
+    "    \"name\": \"3\",\n"
+    "    \"monitor\": \"DP-1\",\n"
+    "    \"monitorID\": 0,\n"
+    "    \"windows\": 4,\n"
+    "    \"hasfullscreen\": false,\n"
+    "    \"lastwindow\": \"0x55d0c5a10000\",\n"
+    "    \"lastwindowtitle\": \"Document 0\",\n"
+    "    \"ispersistent\": false\n"
+    "}";
+
+static struct {
+  int listen_fd;
+  pthread_t thread;
+  char dir[64];
+  char *clients;
+  size_t clients_len;
+  int delay_us; /* Added before each reply */
+  bool quit;
+} mock = {.listen_fd = -1};
+
+static void mock_send(int fd, const char *data, size_t len) {
+  while (len > 0) {
+    ssize_t w = send(fd, data, len, MSG_NOSIGNAL);
+    if (w < 0 && errno == EINTR)
+      continue;
+    if (w <= 0)
+      return;
+    data += w;
+    len -= (size_t)w;
+  }
+}
+
+/* Answer one command; false if it is not one the mock knows */
+static bool mock_reply(int fd, const char *cmd, size_t len) {
+  if (len == strlen("j/activeworkspace") &&
+      strncmp(cmd, "j/activeworkspace", len) == 0) {
+    mock_send(fd, bench_active_ws_json, strlen(bench_active_ws_json));
+    return true;
+  }
+  if (len == strlen("j/clients") && strncmp(cmd, "j/clients", len) == 0) {
+    mock_send(fd, mock.clients, mock.clients_len);
+    return true;
+  }
+  mock_send(fd, "unknown request", strlen("unknown request"));
+  return false;
+}
+
+static void *mock_main(void *arg) {
+  (void)arg;
+  char cmd[IPC_CMD_MAX];
+  for (;;) {
+    int fd = accept(mock.listen_fd, NULL, NULL);
+    if (fd < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    if (__atomic_load_n(&mock.quit, __ATOMIC_ACQUIRE)) {
+      close(fd);
+      break;
+    }
+
+    ssize_t n = read(fd, cmd, sizeof(cmd) - 1);
+    if (n > 0) {
+      cmd[n] = '\0';
+      if (mock.delay_us > 0)
+        nanosleep(&(struct timespec){0, mock.delay_us * 1000L}, NULL);
+      const char *p = cmd;
+      if (strncmp(p, "[[BATCH]]", 9) == 0) {
+        p += 9;
+        for (bool first = true; *p; first = false) {
+          size_t len = strcspn(p, ";");
+          if (!first)
+            mock_send(fd, "\n\n\n", 3);
+          mock_reply(fd, p, len);
+          p += len + (p[len] == ';');
+        }
+      } else {
+        mock_reply(fd, p, strlen(p));
+      }
+    }
+    close(fd);
+  }
+  return NULL;
+}
+
+/* Listen in a private directory and point ipc_addr at it */
+static bool mock_start(void) {
+  snprintf(mock.dir, sizeof(mock.dir), "/tmp/snappy-bench-XXXXXX");
+  if (!mkdtemp(mock.dir))
+    return false;
+
+  memset(&ipc_addr, 0, sizeof(ipc_addr));
+  ipc_addr.sun_family = AF_UNIX;
+  snprintf(ipc_addr.sun_path, sizeof(ipc_addr.sun_path), "%s/.socket.sock",
+           mock.dir);
+
+  mock.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (mock.listen_fd < 0 ||
+      bind(mock.listen_fd, (struct sockaddr *)&ipc_addr, sizeof(ipc_addr)) <
+          0 ||
+      listen(mock.listen_fd, 16) < 0 ||
+      pthread_create(&mock.thread, NULL, mock_main, NULL) != 0) {
+    if (mock.listen_fd >= 0)
+      close(mock.listen_fd);
+    mock.listen_fd = -1;
+    unlink(ipc_addr.sun_path);
+    rmdir(mock.dir);
+    return false;
+  }
+  return true;
+}
+
+static void mock_stop(void) {
+  /* Wake accept() with a connection of our own */
+  __atomic_store_n(&mock.quit, true, __ATOMIC_RELEASE);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd >= 0) {
+    connect(fd, (struct sockaddr *)&ipc_addr, sizeof(ipc_addr));
+    close(fd);
+  }
+  pthread_join(mock.thread, NULL);
+  close(mock.listen_fd);
+  mock.listen_fd = -1;
+  unlink(ipc_addr.sun_path);
+  rmdir(mock.dir);
+}
+
+/* Run the daemon's IPC loop until *done */
+static bool bench_ipc_wait(const bool *done) {
+  while (!*done) {
+    struct pollfd fds[HYPRLAND_IPC_MAX_FDS];
+    int n = hyprland_ipc_pollfds(fds, HYPRLAND_IPC_MAX_FDS);
+    if (n == 0)
+      return false; /* Nothing in flight and not done: a request failed */
+    if (poll(fds, n, IPC_TIMEOUT_MS) < 0 && errno != EINTR)
+      return false;
+    hyprland_ipc_dispatch(fds, n);
+  }
+  return true;
+}
+
+/* The resync before [[BATCH]]: j/clients, then j/activeworkspace once the
+ * first reply is in */
+static bool seq_done;
+
+static void on_seq_active_workspace(char *resp, size_t len, void *user) {
+  (void)user;
+  if (resp) {
+    JsonScan s = {resp, resp + len};
+    model.active_ws = parse_active_workspace(&s);
+  }
+  seq_done = true;
+}
+
+static void on_seq_clients(char *resp, size_t len, void *user) {
+  (void)user;
+  JsonScan s = {resp, resp + len};
+  if (!resp || parse_clients(&s) < 0 ||
+      ipc_submit("j/activeworkspace", on_seq_active_workspace, NULL) < 0)
+    seq_done = true;
+}
+
+static bool batch_done;
+
+static void on_batch_synced(void) { batch_done = true; }
+
+/* ms per resync, batched or sequential, over BENCH_RESYNC_ROUNDS */
+static double bench_resync_sample(void *ctx) {
+  bool batched = *(const bool *)ctx;
+  double t0 = bench_now_ms();
+  for (int r = 0; r < BENCH_RESYNC_ROUNDS; r++) {
+    bool ok;
+    if (batched) {
+      batch_done = false;
+      ok = resync_model() == 0 && bench_ipc_wait(&batch_done);
+    } else {
+      seq_done = false;
+      ok = ipc_submit("j/clients", on_seq_clients, NULL) == 0 &&
+           bench_ipc_wait(&seq_done);
+    }
+    if (!ok)
+      return -1;
+  }
+  return (bench_now_ms() - t0) / BENCH_RESYNC_ROUNDS;
+}
+
+void bench_resync(void) {
+  static const int delays_us[] = {0, 1000};
+
+  mock.clients = bench_clients_json(BENCH_RESYNC_WINDOWS, &mock.clients_len);
+  if (!mock.clients || !mock_start()) {
+    printf("  could not start the mock Hyprland socket\n");
+    free(mock.clients);
+    return;
+  }
+  hyprland_set_windows_changed_callback(on_batch_synced);
+  printf("  %d windows (%zu bytes of j/clients), %d resyncs per sample\n",
+         BENCH_RESYNC_WINDOWS, mock.clients_len, BENCH_RESYNC_ROUNDS);
+
+  for (size_t d = 0; d < sizeof(delays_us) / sizeof(delays_us[0]); d++) {
+    mock.delay_us = delays_us[d];
+    for (int batched = 0; batched < 2; batched++) {
+      char label[64];
+      snprintf(label, sizeof(label), "%s, +%d ms delay",
+               batched ? "batched" : "sequential", delays_us[d] / 1000);
+      bool b = batched;
+      bench_run_samples(bench_resync_sample, &b, label);
+    }
+  }
+
+  hyprland_set_windows_changed_callback(NULL);
+  mock_stop();
+  ipc_cleanup();
+  model_clear();
+  free(mock.clients);
+  mock.clients = NULL;
+}
+
+/* --- Context-mode aggregation --- */
+
+#define BENCH_AGGREGATE_REPS 20
+
+/* The grouping before the hash table: every window compared with every
+ * card so far, strings copied into a new array */
+static void bench_aggregate_linear(AppState *state) {
+  int count = state->count;
+  WindowInfo *out = malloc(count * sizeof(WindowInfo));
+  if (!out)
+    return;
+  int out_count = 0;
+
+  for (int i = 0; i < count; i++) {
+    WindowInfo *win = &state->windows[i];
+    int found = -1;
+    if (!win->is_floating) {
+      for (int j = 0; j < out_count; j++) {
+        if (!out[j].is_floating && out[j].workspace_id == win->workspace_id &&
+            strcmp(out[j].class_name, win->class_name) == 0) {
+          found = j;
+          break;
+        }
+      }
+    }
+
+    if (found >= 0) {
+      out[found].group_count++;
+    } else {
+      out[out_count] = *win;
+      out[out_count].title = bench_strdup(win->title);
+      out[out_count].class_name = bench_strdup(win->class_name);
+      out[out_count].workspace_name = bench_strdup(win->workspace_name);
+      out[out_count].group_count = 1;
+      out_count++;
+    }
+  }
+
+  for (int i = 0; i < out_count; i++) {
+    free(out[i].title);
+    free(out[i].class_name);
+    free(out[i].workspace_name);
+  }
+  free(out);
+}
+
+/* `count` windows: `classes` apps spread over 9 workspaces, every 10th
+ * window floating */
+static void bench_aggregate_fill(AppState *state, int count, int classes) {
+  app_state_init(state);
+  app_state_reserve_strings(state, (size_t)count * 48);
+  for (int i = 0; i < count; i++) {
+    char cls[32], ws[16];
+    snprintf(cls, sizeof(cls), "%s-%d",
+             bench_client_classes[i % BENCH_CLIENT_CLASS_COUNT], i % classes);
+    snprintf(ws, sizeof(ws), "%d", 1 + i % 9);
+
+    WindowInfo info = {0};
+    info.id = 0x1000 + i;
+    info.title = app_state_intern(state, "Window");
+    info.class_name = app_state_intern(state, cls);
+    info.workspace_id = 1 + i % 9;
+    info.workspace_name = app_state_intern(state, ws);
+    info.focus_history_id = i;
+    info.is_floating = i % 10 == 9;
+    info.group_count = 1;
+    info.member_offset = -1;
+    app_state_add(state, &info);
+  }
+}
+
+typedef struct {
+  const AppState *tmpl;
+  bool linear;
+} AggregateSample;
+
+/* ms per aggregation of `tmpl`, each run on a fresh copy of its list */
+static double bench_aggregate_sample(void *ctx) {
+  const AggregateSample *a = ctx;
+  const AppState *tmpl = a->tmpl;
+  double total = 0;
+  for (int r = 0; r < BENCH_AGGREGATE_REPS; r++) {
+    AppState state = *tmpl;
+    state.windows = malloc(tmpl->count * sizeof(WindowInfo));
+    if (!state.windows)
+      return -1;
+    memcpy(state.windows, tmpl->windows, tmpl->count * sizeof(WindowInfo));
+    state.members = NULL;
+    state.group_members = NULL;
+
+    double t0 = bench_now_ms();
+    if (a->linear)
+      bench_aggregate_linear(&state);
+    else
+      aggregate_context(&state);
+    total += bench_now_ms() - t0;
+
+    free(state.windows);
+    free(state.members);
+    free(state.group_members);
+  }
+  return total / BENCH_AGGREGATE_REPS;
+}
+
+void bench_aggregate(void) {
+  static const int counts[] = {100, 500, 1000, 2000};
+  static const struct {
+    int classes; /* Per app name; 0 = one per window */
+    const char *name;
+  } shapes[] = {
+      {1, "12 apps"},
+      {0, "all distinct"},
+  };
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    printf("  %d windows\n", counts[c]);
+    for (size_t s = 0; s < sizeof(shapes) / sizeof(shapes[0]); s++) {
+      AppState tmpl;
+      bench_aggregate_fill(&tmpl, counts[c],
+                           shapes[s].classes ? shapes[s].classes : counts[c]);
+      for (int linear = 0; linear < 2; linear++) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s, %s", shapes[s].name,
+                 linear ? "linear scan" : "hash table");
+        AggregateSample a = {&tmpl, linear};
+        bench_run_samples(bench_aggregate_sample, &a, label);
+      }
+      app_state_free(&tmpl);
+    }
+  }
+}
+
+/* --- Snapshots from the maintained indices --- */
+
+#define BENCH_SNAPSHOT_REPS 50
+#define BENCH_EVENTS 2000
+
+/* The order update_window_list() used to produce with qsort() (the old
+ * address tie-break compared strings; numbers favor the old code) */
+static int bench_compare_mru(const void *a, const void *b) {
+  const WindowInfo *wa = a, *wb = b;
+  if (wa->focus_history_id != wb->focus_history_id)
+    return wa->focus_history_id - wb->focus_history_id;
+  return (wa->id > wb->id) - (wa->id < wb->id);
+}
+
+static int bench_compare_linear(const void *a, const void *b) {
+  const WindowInfo *wa = a, *wb = b;
+  if (wa->workspace_id != wb->workspace_id)
+    return wa->workspace_id - wb->workspace_id;
+  return (wa->id > wb->id) - (wa->id < wb->id);
+}
+
+typedef struct {
+  bool linear;
+  bool sorted;
+} SnapshotSample;
+
+/* ms per snapshot of the current model; `sorted`: walk the other index
+ * and qsort() the copy into order, as before the indices existed */
+static double bench_snapshot_sample(void *ctx) {
+  bool linear = ((const SnapshotSample *)ctx)->linear;
+  bool sorted = ((const SnapshotSample *)ctx)->sorted;
+  double total = 0;
+  for (int r = 0; r < BENCH_SNAPSHOT_REPS; r++) {
+    AppState state;
+    app_state_init(&state);
+    double t0 = bench_now_ms();
+    update_window_list(&state, NULL, sorted ? !linear : linear);
+    if (sorted)
+      qsort(state.windows, state.count, sizeof(WindowInfo),
+            linear ? bench_compare_linear : bench_compare_mru);
+    total += bench_now_ms() - t0;
+    app_state_free(&state);
+  }
+  return total / BENCH_SNAPSHOT_REPS;
+}
+
+typedef struct {
+  int count;
+  bool move;
+} EventsSample;
+
+/* ms per event: focus changes, or moves to another workspace, cycling
+ * through the windows */
+static double bench_events_sample(void *ctx) {
+  int count = ((const EventsSample *)ctx)->count;
+  bool move = ((const EventsSample *)ctx)->move;
+  double total = 0;
+  for (int e = 0; e < BENCH_EVENTS; e++) {
+    uint64_t addr =
+        (uint64_t)0x55d0c5a10000 + (uint64_t)(e * 7 % count) * 0x1d0;
+    char line[96];
+    if (move)
+      snprintf(line, sizeof(line), "movewindowv2>>%" PRIx64 ",%d,%d", addr,
+               1 + e % 9, 1 + e % 9);
+    else
+      snprintf(line, sizeof(line), "activewindowv2>>%" PRIx64, addr);
+    double t0 = bench_now_ms();
+    handle_event(line);
+    total += bench_now_ms() - t0;
+  }
+  return total / BENCH_EVENTS;
+}
+
+void bench_snapshot(void) {
+  static const int counts[] = {100, 500, 1000, 2000};
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    size_t len;
+    char *json = bench_clients_json(counts[c], &len);
+    JsonScan s = {json, json + len};
+    if (!json || parse_clients(&s) < 0) {
+      printf("  could not build the window model\n");
+      free(json);
+      return;
+    }
+    model.synced = true; /* No resync: the model is current */
+    printf("  %d windows\n", counts[c]);
+
+    for (int linear = 0; linear < 2; linear++) {
+      for (int sorted = 0; sorted < 2; sorted++) {
+        char label[64];
+        snprintf(label, sizeof(label), "%s snapshot, %s",
+                 linear ? "linear" : "MRU", sorted ? "qsort" : "indexed");
+        SnapshotSample sn = {linear, sorted};
+        bench_run_samples(bench_snapshot_sample, &sn, label);
+      }
+    }
+    for (int move = 0; move < 2; move++) {
+      EventsSample ev = {counts[c], move};
+      bench_run_samples(bench_events_sample, &ev,
+                        move ? "movewindowv2 event" : "activewindowv2 event");
+    }
+
+    model_clear();
+    free(json);
+  }
+}
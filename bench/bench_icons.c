@@ -0,0 +1,146 @@
+/* bench/bench_icons.c - Icon cache benchmarks
+ *
+ * Uses the public icons.h API only.  Classes named "bench-app-N" have no
+ * icon, so the cache holds them as known misses: a hit on one costs the
+ * same lookup as a hit on a decoded icon, without needing icon files.
+ */
+#define _POSIX_C_SOURCE 200809L
+
+#include "../src/config.h"
+#include "../src/icons.h"
+#include "bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_ICON_SIZE 48
+#define BENCH_ICON_SCALE 2
+#define BENCH_LOOKUPS 100000
+#define BENCH_RESOLVES 200
+
+#define OLD_CACHE_MAX 256
+
+/* The cache before the hash table: a fixed array scanned with strcmp(),
+ * never holding more than OLD_CACHE_MAX classes */
+typedef struct {
+  char class_name[128];
+  int size;
+  cairo_surface_t *surface;
+} OldCacheEntry;
+
+static OldCacheEntry old_cache[OLD_CACHE_MAX];
+static int old_cache_count = 0;
+
+static OldCacheEntry *old_cache_find(const char *class_name, int size) {
+  for (int i = 0; i < old_cache_count; i++) {
+    if (strcmp(old_cache[i].class_name, class_name) == 0 &&
+        old_cache[i].size == size)
+      return &old_cache[i];
+  }
+  return NULL;
+}
+
+/* Keeps the lookups' results observable */
+static volatile unsigned long bench_found;
+
+typedef struct {
+  char (*names)[32];
+  int count;
+  bool old;
+} LookupSample;
+
+/* ms per lookup, cycling through `names` */
+static double bench_lookup_sample(void *ctx) {
+  const LookupSample *l = ctx;
+  unsigned long found = 0;
+  double t0 = bench_now_ms();
+  for (int i = 0; i < BENCH_LOOKUPS; i++) {
+    const char *name = l->names[i % l->count];
+    if (l->old) {
+      found += old_cache_find(name, BENCH_ICON_SIZE) != NULL;
+    } else {
+      bool pending;
+      cairo_surface_t *s =
+          icons_lookup(name, BENCH_ICON_SIZE, BENCH_ICON_SCALE, &pending);
+      found += !pending;
+      if (s)
+        cairo_surface_destroy(s);
+    }
+  }
+  bench_found = found;
+  return (bench_now_ms() - t0) / BENCH_LOOKUPS;
+}
+
+/* ms per full resolution of a class never seen; `ctx` counts the calls,
+ * which keeps the names unique */
+static double bench_resolve_sample(void *ctx) {
+  int *call = ctx;
+  double t0 = bench_now_ms();
+  for (int r = 0; r < BENCH_RESOLVES; r++) {
+    char name[32];
+    snprintf(name, sizeof(name), "bench-new-%d-%d", *call, r);
+    cairo_surface_t *s = load_app_icon(name, BENCH_ICON_SIZE, BENCH_ICON_SCALE);
+    if (s)
+      cairo_surface_destroy(s);
+  }
+  (*call)++;
+  return (bench_now_ms() - t0) / BENCH_RESOLVES;
+}
+
+void bench_icon_cache(void) {
+  static const int counts[] = {48, 256, 1024};
+  Config *config = bench_config_create();
+  if (!config)
+    return;
+  icons_init(config->icon_theme, config->icon_fallback, 0);
+  printf("  %d lookups per sample, size %d at scale %d\n", BENCH_LOOKUPS,
+         BENCH_ICON_SIZE, BENCH_ICON_SCALE);
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+    int count = counts[c];
+    char(*names)[32] = malloc(count * sizeof(*names));
+    if (!names)
+      break;
+    old_cache_count = 0;
+    for (int i = 0; i < count; i++) {
+      snprintf(names[i], sizeof(names[i]), "bench-app-%d", i);
+      cairo_surface_t *s =
+          load_app_icon(names[i], BENCH_ICON_SIZE, BENCH_ICON_SCALE);
+      if (s)
+        cairo_surface_destroy(s);
+      if (old_cache_count < OLD_CACHE_MAX) {
+        OldCacheEntry *e = &old_cache[old_cache_count++];
+        snprintf(e->class_name, sizeof(e->class_name), "%s", names[i]);
+        e->size = BENCH_ICON_SIZE;
+        e->surface = NULL;
+      }
+    }
+
+    printf("  %d classes cached\n", count);
+    for (int old = 0; old < 2; old++) {
+      /* Past OLD_CACHE_MAX the old cache only scans the classes it holds;
+       * the rest miss and are resolved again (see below) */
+      int n = old && count > OLD_CACHE_MAX ? OLD_CACHE_MAX : count;
+      LookupSample l = {names, n, old};
+      bench_run_samples(bench_lookup_sample, &l,
+                        old ? "lookup, linear array" : "lookup, hash table");
+    }
+    if (count > OLD_CACHE_MAX)
+      printf("  %-28s %d of %d classes resolved again on every frame\n",
+             "linear array, full:", count - OLD_CACHE_MAX, count);
+    free(names);
+  }
+
+  /* What each of those costs */
+  int calls = 0;
+  bench_run_samples(bench_resolve_sample, &calls, "resolve an uncached class");
+
+  IconCacheStats stats;
+  icons_get_stats(&stats);
+  printf("  cache: %d entries, %zu KiB of %zu KiB, %lu evictions\n",
+         stats.entries, stats.bytes >> 10, stats.budget >> 10,
+         stats.evictions);
+
+  icons_cleanup();
+  bench_config_free(config);
+}
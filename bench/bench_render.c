@@ -0,0 +1,285 @@
+/* bench/bench_render.c - Rendering benchmarks
+ *
+ * Includes src/render.c whole so the raster pool and card cache can be
+ * driven directly: no Wayland connection, buffers or render thread.
+ */
+#include "../src/render.c"
+
+#include "bench.h"
+#include <poll.h>
+#include <sys/stat.h>
+
+/* Defined by main.c in the daemon; only the buffer code (unused here)
+ * touches them */
+struct wl_compositor *compositor = NULL;
+struct wl_shm *shm = NULL;
+struct wl_surface *surface = NULL;
+
+#define BENCH_CARDS 48 /* A 6 x 8 grid at the default max_cols */
+#define BENCH_SCALE 2
+
+static const char *bench_classes[] = {
+    "firefox", "kitty",   "code",    "org.gnome.Nautilus",
+    "mpv",     "discord", "obsidian", "thunderbird",
+    "gimp",    "Slack",   "steam",    "some-app-without-an-icon",
+};
+
+#define BENCH_CLASS_COUNT                                                      \
+  (int)(sizeof(bench_classes) / sizeof(bench_classes[0]))
+
+/* A fixed grid: varied classes, workspaces and title lengths */
+static void bench_grid_fill(AppState *state, int count) {
+  app_state_init(state);
+  app_state_reserve_strings(state, (size_t)count * 192);
+  for (int i = 0; i < count; i++) {
+    char title[128], ws[16];
+    snprintf(title, sizeof(title),
+             i % 3 ? "Document %d - Editor" :
+                     "A much longer window title %d that has to be "
+                     "ellipsized to fit on its card",
+             i);
+    snprintf(ws, sizeof(ws), "%d", 1 + i % 9);
+
+    WindowInfo info = {0};
+    info.id = 0x1000 + i;
+    info.title = app_state_intern(state, title);
+    info.class_name =
+        app_state_intern(state, bench_classes[i % BENCH_CLASS_COUNT]);
+    info.workspace_id = 1 + i % 9;
+    info.workspace_name = app_state_intern(state, ws);
+    info.focus_history_id = i;
+    info.is_active = i == 0;
+    info.group_count = i % 7 == 0 ? 3 : 1;
+    info.member_offset = -1;
+    app_state_add(state, &info);
+  }
+  state->selected_index = 1;
+}
+
+/* Wait until every icon of the grid is in the memory cache (or known to
+ * be missing), so timed rounds draw real icons without loading any */
+static void bench_icons_settle(AppState *state, int scale) {
+  for (int tries = 0; tries < 100; tries++) {
+    icons_begin_show(); /* Landings past the show deadline signal nothing */
+    bool pending_any = false;
+    for (int i = 0; i < state->count; i++) {
+      bool pending;
+      cairo_surface_t *icon = icons_lookup(state->windows[i].class_name,
+                                           theme.icon_size, scale, &pending);
+      if (icon)
+        cairo_surface_destroy(icon);
+      pending_any |= pending;
+    }
+    if (!pending_any)
+      return;
+    struct pollfd pfd = {.fd = icons_get_event_fd(), .events = POLLIN};
+    if (pfd.fd >= 0 && poll(&pfd, 1, 100) > 0)
+      icons_dispatch_events();
+  }
+}
+
+/* The grid half of draw_frame(): look up every card, rasterize the
+ * missing tiles, store them.  Returns the number of tiles drawn. */
+static int bench_grid_rasterize(AppState *state, int scale) {
+  static char tags[BENCH_CARDS][CARD_TAG_MAX];
+  int count = state->count < BENCH_CARDS ? state->count : BENCH_CARDS;
+
+  letter_tracker_init(&g_letter_tracker);
+  raster.job_count = 0;
+  for (int i = 0; i < count; i++) {
+    bool selected = i == state->selected_index;
+    tags[i][0] = '\0';
+    if (theme.show_workspace_badge)
+      format_workspace_tag(&state->windows[i], &g_letter_tracker, tags[i],
+                           sizeof(tags[i]));
+    CardEntry *e = card_cache_get(&state->windows[i], tags[i], scale, i);
+    if (!e || e->tile[selected])
+      continue;
+    RasterJob *job = raster_add_job();
+    if (job)
+      *job = (RasterJob){.win = &state->windows[i],
+                         .tag = tags[i],
+                         .selected = selected,
+                         .scale = scale,
+                         .entry = (int)(e - card_cache)};
+  }
+
+  int drawn = raster.job_count;
+  raster_run(scale);
+  for (int j = 0; j < drawn; j++) {
+    RasterJob *job = &raster.jobs[j];
+    CardEntry *e = &card_cache[job->entry];
+    e->tile[job->selected] = job->tile;
+    if (job->assets.icon_pending) {
+      e->icon_pending = true;
+      e->icon_wait = job->assets.icon_gen;
+    }
+  }
+  return drawn;
+}
+
+/* ms to rasterize the grid of `ctx` (an AppState) from empty tile and
+ * title caches, as on the first show or after a theme change; icons are
+ * already loaded */
+static double bench_raster_sample(void *ctx) {
+  card_cache_free();
+  title_cache_free();
+  double t0 = bench_now_ms();
+  bench_grid_rasterize(ctx, BENCH_SCALE);
+  return bench_now_ms() - t0;
+}
+
+void bench_raster(void) {
+  static const int thread_counts[] = {1, 2, 4, 8};
+  Config *config = bench_config_create();
+  if (!config)
+    return;
+  render_set_config(config);
+  icons_init(config->icon_theme, config->icon_fallback,
+             config->icon_cache_mb > 0 ? (size_t)config->icon_cache_mb << 20
+                                       : 0);
+
+  AppState state;
+  bench_grid_fill(&state, BENCH_CARDS);
+  bench_icons_settle(&state, BENCH_SCALE);
+  printf("  %d cards, scale %d, %d rounds, %ld cores\n", BENCH_CARDS,
+         BENCH_SCALE, BENCH_SAMPLES, sysconf(_SC_NPROCESSORS_ONLN));
+
+  for (size_t t = 0; t < sizeof(thread_counts) / sizeof(thread_counts[0]);
+       t++) {
+    raster_stop();
+    config->render_threads = thread_counts[t];
+    render_set_config(config);
+
+    raster_start(); /* Otherwise on the first batch; the label needs it */
+    char label[64];
+    snprintf(label, sizeof(label), "%d thread%s (%d used)", thread_counts[t],
+             thread_counts[t] == 1 ? "" : "s", raster.count + 1);
+    bench_run_samples(bench_raster_sample, &state, label);
+  }
+
+  app_state_free(&state);
+  raster_stop();
+  card_cache_free();
+  title_cache_free();
+  text_resources_free();
+  chrome_free();
+  theme_free();
+  icons_cleanup();
+  bench_config_free(config);
+}
+
+/* --- Cold vs warm first frame ---
+ *
+ * Startup with an empty icon disk cache, then again with the file the
+ * first run wrote.  Each run times icons_init(), the first grid frame
+ * (cards whose icon is still loading show a placeholder), and the time
+ * until a redrawn grid shows every icon.  The show deadline is renewed
+ * before each redraw, so every icon that lands gets drawn.  Each row is
+ * its own series of runs, after a throwaway one, so the page cache is
+ * equally warm for all of them.
+ */
+
+#define BENCH_STARTUP_TIMEOUT_MS 5000
+
+typedef struct {
+  double init_ms;     /* icons_init() */
+  double first_ms;    /* ...plus the first grid frame */
+  double complete_ms; /* ...until a frame shows every icon */
+  int redraws;
+} StartupTiming;
+
+static bool grid_icons_pending(void) {
+  for (int i = 0; i < card_cache_count; i++)
+    if (card_cache[i].icon_pending)
+      return true;
+  return false;
+}
+
+static StartupTiming bench_startup(const Config *config, AppState *state) {
+  StartupTiming t = {0};
+  card_cache_free();
+  title_cache_free();
+
+  double t0 = bench_now_ms();
+  icons_init(config->icon_theme, config->icon_fallback,
+             config->icon_cache_mb > 0 ? (size_t)config->icon_cache_mb << 20
+                                       : 0);
+  t.init_ms = bench_now_ms() - t0;
+
+  icons_begin_show();
+  bench_grid_rasterize(state, BENCH_SCALE);
+  t.first_ms = bench_now_ms() - t0;
+
+  while (grid_icons_pending() &&
+         bench_now_ms() - t0 < BENCH_STARTUP_TIMEOUT_MS) {
+    struct pollfd pfd = {.fd = icons_get_event_fd(), .events = POLLIN};
+    if (pfd.fd >= 0 && poll(&pfd, 1, 100) > 0)
+      icons_dispatch_events();
+    icons_begin_show(); /* Also flags icons that landed past the deadline */
+    if (bench_grid_rasterize(state, BENCH_SCALE) > 0)
+      t.redraws++;
+  }
+  t.complete_ms = bench_now_ms() - t0;
+
+  icons_cleanup(); /* Writes the disk cache */
+  return t;
+}
+
+typedef struct {
+  const Config *config;
+  AppState *state;
+  bool warm;  /* Keep the disk cache the previous run wrote */
+  int metric; /* 0: init_ms, 1: first_ms, 2: complete_ms */
+  int runs;
+  int redraws;
+} StartupSample;
+
+static double bench_startup_sample(void *ctx) {
+  StartupSample *s = ctx;
+  if (!s->warm)
+    unlink(bench_cache_file());
+  StartupTiming t = bench_startup(s->config, s->state);
+  s->runs++;
+  s->redraws += t.redraws;
+  return s->metric == 0 ? t.init_ms :
+         s->metric == 1 ? t.first_ms : t.complete_ms;
+}
+
+void bench_startup_icons(void) {
+  Config *config = bench_config_create();
+  if (!config)
+    return;
+  render_set_config(config);
+
+  AppState state;
+  bench_grid_fill(&state, BENCH_CARDS);
+  printf("  %d cards at scale %d, %d runs per row\n", BENCH_CARDS,
+         BENCH_SCALE, BENCH_SAMPLES);
+
+  static const char *what[] = {"icons_init", "first frame", "all icons shown"};
+  for (int warm = 0; warm < 2; warm++) {
+    StartupSample s = {config, &state, warm, 0, 0, 0};
+    for (s.metric = 0; s.metric < 3; s.metric++) {
+      char label[64];
+      snprintf(label, sizeof(label), "%s: %s", warm ? "warm" : "cold",
+               what[s.metric]);
+      bench_run_samples(bench_startup_sample, &s, label);
+    }
+    printf("  %-28s %.1f redraws per run\n", warm ? "warm" : "cold",
+           s.runs ? (double)s.redraws / s.runs : 0);
+  }
+
+  struct stat st;
+  if (stat(bench_cache_file(), &st) == 0)
+    printf("  disk cache: %lld KiB\n", (long long)st.st_size / 1024);
+
+  app_state_free(&state);
+  raster_stop();
+  card_cache_free();
+  title_cache_free();
+  text_resources_free();
+  chrome_free();
+  theme_free();
+  bench_config_free(config);
+}
@@ -4,6 +4,7 @@
 
 #include "config.h"
 #include "data.h"
+#include <time.h>
 
 /* Backend types */
 typedef enum { BACKEND_HYPRLAND, BACKEND_WLR, BACKEND_UNKNOWN } BackendType;
@@ -14,7 +15,9 @@ typedef struct {
   int (*init)(void);
   void (*cleanup)(void);
   int (*get_windows)(AppState *state, Config *config, bool is_linear);
-  void (*activate_window)(const char *identifier);
+  /* `started` (CLOCK_MONOTONIC, may be NULL) is when the user asked for
+   * the switch; the backend logs the latency from there */
+  void (*activate_window)(uint64_t id, const struct timespec *started);
   const char *(*get_name)(void);
 } Backend;
 
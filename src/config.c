@@ -19,6 +19,8 @@ static void set_defaults(Config *cfg) {
   cfg->follow_monitor = false;
   cfg->show_workspace_badge = true;
   cfg->sticky_mode = false;
+  cfg->buffer_count = 2;
+  cfg->render_threads = 0;
   /* Default Fallback / Debug Colors (0xRRGGBBAA) */
   cfg->background = 0xff0000ff;
   cfg->card_bg = 0x0000ffff;
@@ -54,6 +56,7 @@ static void set_defaults(Config *cfg) {
   strncpy(cfg->icon_fallback, "Tela-circle-dracula",
           sizeof(cfg->icon_fallback) - 1);
   cfg->show_letter_fallback = true;
+  cfg->icon_cache_mb = 32;
 
   /* Font */
   strncpy(cfg->font_family, "Sans", sizeof(cfg->font_family) - 1);
@@ -107,6 +110,10 @@ static void apply_value(Config *cfg, const char *section, const char *key,
     } else if (strcasecmp(key, "sticky_mode") == 0) {
       cfg->sticky_mode =
           (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    } else if (strcasecmp(key, "buffer_count") == 0) {
+      cfg->buffer_count = atoi(val);
+    } else if (strcasecmp(key, "render_threads") == 0) {
+      cfg->render_threads = atoi(val);
     }
   }
   /* Colors (from theme or manual override) */
@@ -173,6 +180,8 @@ static void apply_value(Config *cfg, const char *section, const char *key,
     else if (strcasecmp(key, "show_letter_fallback") == 0)
       cfg->show_letter_fallback =
           (strcasecmp(val, "true") == 0 || strcmp(val, "1") == 0);
+    else if (strcasecmp(key, "cache_size") == 0)
+      cfg->icon_cache_mb = atoi(val);
   }
   /* Font */
   else if (strcasecmp(section, "font") == 0) {
@@ -53,6 +53,7 @@ typedef struct {
   char icon_theme[64];
   char icon_fallback[64];
   bool show_letter_fallback;
+  int icon_cache_mb; /* Memory budget for decoded icons */
 
   /* View Mode */
   bool follow_monitor;
@@ -60,6 +61,10 @@ typedef struct {
   ViewMode mode;
   bool sticky_mode;
 
+  /* Rendering */
+  int buffer_count;   /* Buffer ring depth (2-4) */
+  int render_threads; /* Card raster threads, 0 = one per core (max 8) */
+
 } Config;
 
 /* Load config from default path (~/.config/snappy-switcher/config.ini) */
@@ -6,9 +6,10 @@
 #include <stdint.h>
 #include <wayland-client.h>
 
-/* Information about a single window */
+/* Information about a single window.
+ * String fields point into the owning AppState's string arena. */
 typedef struct {
-  char *address;        /* Window address (hex string) */
+  uint64_t id;          /* Window id: Hyprland address or WLR handle id */
   char *title;          /* Window title */
   char *class_name;     /* Application class name */
   int workspace_id;     /* Workspace ID (Negative for special workspaces) */
@@ -17,20 +18,33 @@ typedef struct {
   bool is_active;       /* Whether this window is currently focused */
   bool is_floating;     /* Whether this window is floating (not tiled) */
   int group_count;      /* Number of windows in this group */
+  int member_offset;    /* Context mode: start of this group's entries in
+                           AppState.group_members, -1 if not grouped */
 } WindowInfo;
 
-/* A single in-flight Wayland buffer and its backing resources.
+/* A single in-flight Wayland buffer, sub-allocated from the shared SHM arena.
  * The compositor reads the buffer asynchronously after wl_surface_commit(),
- * so we must keep it alive until the wl_buffer::release event fires. */
+ * so its region must not be reused until the wl_buffer::release event fires.
+ * The render thread owns the region and its pixels; the main thread owns the
+ * wl_buffer, kept across frames while the region's layout is unchanged. */
 typedef struct {
-  struct wl_buffer *buffer;  /* Wayland buffer object                */
-  struct wl_shm_pool *pool;  /* SHM pool that created the buffer     */
-  void *data;                /* mmap'd shared memory                 */
-  int size;                  /* Size of the mmap'd region in bytes   */
-  int fd;                    /* File descriptor (closed after pool)  */
-  bool in_use;               /* True while compositor holds the buf  */
-  uint32_t alloc_width;      /* Physical width this buffer was sized for  */
-  uint32_t alloc_height;     /* Physical height this buffer was sized for */
+  /* Main thread */
+  struct wl_buffer *buffer;  /* Wayland buffer object (NULL = none)  */
+  int buffer_offset;         /* Layout `buffer` was created with     */
+  int buffer_stride;
+  uint32_t buffer_width;
+  uint32_t buffer_height;
+  uint32_t buffer_format;
+  /* Render thread */
+  void *data;                /* Pixels: arena mapping + offset       */
+  int offset;                /* Byte offset of the region in the arena */
+  int size;                  /* Bytes reserved for this buffer       */
+  uint32_t width;            /* Physical width the pixels are drawn at  */
+  uint32_t height;           /* Physical height the pixels are drawn at */
+  uint32_t format;           /* WL_SHM_FORMAT_* of the pixels           */
+  uint64_t frame_serial;     /* Frame whose pixels it holds (0 = none)    */
+  /* Both */
+  bool in_use;               /* Atomic: compositor or frame holds it */
 } RenderBuffer;
 
 /* Application state */
@@ -45,8 +59,9 @@ typedef struct {
   uint32_t height;
   int cols; /* Number of columns in the current grid layout */
 
-  /* Dirty flag: set to true by input handlers, consumed by main loop */
-  bool needs_render;
+  /* State changes waiting for the next frame: bumped by input handlers,
+   * cleared by the main loop once a frame carrying them is committed */
+  int needs_render;
 
   /* Error state: non-NULL means an error banner should be displayed.
    * Heap-allocated; freed by hide_switcher() / app_state_free(). */
@@ -54,6 +69,18 @@ typedef struct {
 
   /* Workspace filter: when true, only show windows on the active workspace */
   bool filter_workspace;
+
+  /* String arena: all WindowInfo strings of this snapshot live in one
+   * block, so app_state_free() releases them with a single free(). */
+  char *strings;
+  size_t strings_used;
+  size_t strings_size;
+
+  /* Context mode: every window before aggregation (indices into this
+   * array are listed per group in group_members). NULL otherwise. */
+  WindowInfo *members;
+  int member_count;
+  int *group_members;
 } AppState;
 
 /* Initialize AppState */
@@ -61,10 +88,14 @@ void app_state_init(AppState *state);
 
 int app_state_add(AppState *state, WindowInfo *info);
 
+/* Size the string arena for `bytes` of string data (including NULs).
+ * Must be called before the first app_state_intern() of a snapshot. */
+int app_state_reserve_strings(AppState *state, size_t bytes);
+
+/* Copy a string into the arena. Never returns NULL. */
+char *app_state_intern(AppState *state, const char *str);
+
 /* Free all resources held by AppState */
 void app_state_free(AppState *state);
 
-/* Free a single WindowInfo's strings */
-void window_info_free(WindowInfo *info);
-
 #endif /* DATA_H */
@@ -1,12 +1,13 @@
 /* src/hyprland.c - Hyprland IPC and Data Management */
-#define _POSIX_C_SOURCE 200809L
+#define _GNU_SOURCE /* memmem */
 
 #include <stdbool.h>
 
 #include "hyprland.h"
 #include "config.h"
 #include <errno.h>
-#include <json-c/json.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -18,13 +19,27 @@
 #define LOG(fmt, ...) fprintf(stderr, "[Hyprland] " fmt "\n", ##__VA_ARGS__)
 #define BUFFER_SIZE 65536
 #define INITIAL_CAPACITY 32
+#define EVENT_BUFFER_SIZE 16384
+#define ADDRESS_STR_SIZE 20 /* "0x" + 16 hex digits + NUL */
+
+/* Sentinel: no filtering (all workspaces) */
+#define WS_FILTER_NONE -999
 
 /* Cached dispatch syntax flag: true = Lua (v0.55+ with hyprland.lua),
  * false = legacy hyprlang (pre-0.55 or 0.55 with hyprland.conf). */
 static bool use_lua_dispatch = false;
 
-static char *get_socket_path(void);
+/* Persistent IPC context: socket addresses built once at init */
+static struct sockaddr_un ipc_addr;   /* .socket.sock  (requests) */
+static struct sockaddr_un event_addr; /* .socket2.sock (events)   */
+
+static int build_socket_addr(struct sockaddr_un *addr, const char *name);
 static char *hyprland_request(const char *cmd);
+static int events_connect(void);
+static void events_disconnect(void);
+static int resync_model(void);
+static void model_clear(void);
+static void ipc_cleanup(void);
 
 /*
  * Probe Hyprland IPC to determine the correct dispatch syntax.
@@ -91,29 +106,38 @@ static void detect_dispatch_syntax(void) {
 }
 
 int hyprland_backend_init(void) {
-  char *socket_path = get_socket_path();
-  if (!socket_path) {
+  /* Socket addresses are resolved once here and reused by every request */
+  if (build_socket_addr(&ipc_addr, ".socket.sock") < 0 ||
+      build_socket_addr(&event_addr, ".socket2.sock") < 0) {
     LOG("HYPRLAND_INSTANCE_SIGNATURE or XDG_RUNTIME_DIR not set");
     return -1;
   }
 
   /* Test if socket exists */
-  if (access(socket_path, F_OK) != 0) {
-    free(socket_path);
+  if (access(ipc_addr.sun_path, F_OK) != 0) {
     LOG("Hyprland socket not found");
     return -1;
   }
 
-  free(socket_path);
-
-  /* Probe IPC once to determine dispatch syntax */
+  /* Probe IPC once to determine dispatch syntax (blocking, but this runs
+   * before the daemon's poll loop and UI exist) */
   detect_dispatch_syntax();
 
+  /* Subscribe to events before the initial snapshot so nothing that
+   * happens in between is missed.  Without the event socket we still
+   * work, just with a full fetch on every show.  The snapshot itself
+   * completes asynchronously once the poll loop is running. */
+  if (events_connect() < 0)
+    LOG("Event socket unavailable, falling back to polling j/clients");
+  resync_model();
+
   return 0;
 }
 
 void hyprland_backend_cleanup(void) {
-  /* Nothing to cleanup for Hyprland backend */
+  ipc_cleanup();
+  events_disconnect();
+  model_clear();
 }
 
 const char *hyprland_get_name(void) { return "hyprland"; }
@@ -128,43 +152,62 @@ void app_state_init(AppState *state) {
   state->height = 100;
   state->error_message = NULL;
   state->filter_workspace = false;
-}
-
-void window_info_free(WindowInfo *info) {
-  if (info) {
-    free(info->address);
-    free(info->title);
-    free(info->class_name);
-    free(info->workspace_name);
-    memset(info, 0, sizeof(WindowInfo));
-  }
+  state->strings = NULL;
+  state->strings_used = 0;
+  state->strings_size = 0;
+  state->members = NULL;
+  state->member_count = 0;
+  state->group_members = NULL;
 }
 
 void app_state_free(AppState *state) {
   if (state) {
-    if (state->windows) {
-      for (int i = 0; i < state->count; i++) {
-        window_info_free(&state->windows[i]);
-      }
-      free(state->windows);
-    }
+    /* Window strings live in the arena — nothing to free per window */
+    free(state->windows);
     state->windows = NULL;
     state->count = 0;
     state->capacity = 0;
+    free(state->strings);
+    state->strings = NULL;
+    state->strings_used = 0;
+    state->strings_size = 0;
+    free(state->members);
+    state->members = NULL;
+    state->member_count = 0;
+    free(state->group_members);
+    state->group_members = NULL;
     free(state->error_message);
     state->error_message = NULL;
   }
 }
 
-static char *safe_strdup(const char *str) {
-  char *dup = strdup(str ? str : "");
-  if (!dup) {
-    /* OOM fallback: return empty string from static storage.
-     * Callers must tolerate this — all current callers do. */
-    static char empty[] = "";
+int app_state_reserve_strings(AppState *state, size_t bytes) {
+  if (bytes <= state->strings_size)
+    return 0;
+  /* Growing would move strings already handed out */
+  if (state->strings_used > 0)
+    return -1;
+  char *block = realloc(state->strings, bytes);
+  if (!block)
+    return -1;
+  state->strings = block;
+  state->strings_size = bytes;
+  return 0;
+}
+
+char *app_state_intern(AppState *state, const char *str) {
+  static char empty[] = "";
+  if (!str)
+    str = "";
+  size_t len = strlen(str) + 1;
+  if (state->strings_size - state->strings_used < len) {
+    /* Under-reserved or OOM: degrade to an empty string */
     return empty;
   }
-  return dup;
+  char *dst = state->strings + state->strings_used;
+  memcpy(dst, str, len);
+  state->strings_used += len;
+  return dst;
 }
 
 int app_state_add(AppState *state, WindowInfo *info) {
@@ -180,64 +223,34 @@ int app_state_add(AppState *state, WindowInfo *info) {
   return 0;
 }
 
-/* --- Sorting (Stable MRU) --- */
-static int compare_mru(const void *a, const void *b) {
-  const WindowInfo *wa = (const WindowInfo *)a;
-  const WindowInfo *wb = (const WindowInfo *)b;
-
-  int diff = wa->focus_history_id - wb->focus_history_id;
-  if (diff != 0)
-    return diff;
-
-  const char *addr_a = wa->address ? wa->address : "";
-  const char *addr_b = wb->address ? wb->address : "";
-  return strcmp(addr_a, addr_b);
-}
-
-/* --- Sorting (Linear: workspace_id ASC, address ASC) --- */
-static int compare_linear(const void *a, const void *b) {
-  const WindowInfo *wa = (const WindowInfo *)a;
-  const WindowInfo *wb = (const WindowInfo *)b;
-
-  if (wa->workspace_id != wb->workspace_id)
-    return wa->workspace_id - wb->workspace_id;
-
-  const char *addr_a = wa->address ? wa->address : "";
-  const char *addr_b = wb->address ? wb->address : "";
-  return strcmp(addr_a, addr_b);
-}
-
 /* --- IPC --- */
-static char *get_socket_path(void) {
+/* Build the address of a socket in the Hyprland instance directory,
+ * e.g. ".socket.sock" (requests) or ".socket2.sock" (events). */
+static int build_socket_addr(struct sockaddr_un *addr, const char *name) {
   const char *sig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
   const char *xdg = getenv("XDG_RUNTIME_DIR");
   if (!sig || !xdg)
-    return NULL;
+    return -1;
 
-  size_t len = strlen(xdg) + strlen(sig) + 32;
-  char *path = malloc(len);
-  if (path)
-    snprintf(path, len, "%s/hypr/%s/.socket.sock", xdg, sig);
-  return path;
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  int n = snprintf(addr->sun_path, sizeof(addr->sun_path), "%s/hypr/%s/%s",
+                   xdg, sig, name);
+  if (n < 0 || (size_t)n >= sizeof(addr->sun_path)) {
+    LOG("Socket path too long: %s/hypr/%s/%s", xdg, sig, name);
+    return -1;
+  }
+  return 0;
 }
 
+/* Blocking request — only used for the startup probes; everything issued
+ * from the running daemon goes through the async engine below. */
 static char *hyprland_request(const char *cmd) {
-  char *path = get_socket_path();
-  if (!path)
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
     return NULL;
 
-  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
-  if (fd < 0) {
-    free(path);
-    return NULL;
-  }
-
-  struct sockaddr_un addr = {0};
-  addr.sun_family = AF_UNIX;
-  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
-  free(path);
-
-  if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+  if (connect(fd, (struct sockaddr *)&ipc_addr, sizeof(ipc_addr)) < 0) {
     close(fd);
     return NULL;
   }
@@ -291,164 +304,1529 @@ static char *hyprland_request(const char *cmd) {
   return resp;
 }
 
-/* --- Active Workspace Query --- */
+/* --- Async IPC ---
+ *
+ * Once the daemon is running, requests never block the main thread.  Each
+ * one is a small state machine (connecting -> writing -> reading) over a
+ * non-blocking socket whose fd sits in the daemon's poll() set; see
+ * hyprland_ipc_pollfds() / hyprland_ipc_dispatch().  The completion
+ * callback gets the NUL-terminated reply, or NULL on error or timeout.
+ *
+ * The reply is a borrowed view of the slot's response buffer, which is
+ * kept at its high-water mark and reused, so once warmed up a request
+ * performs no allocations at all.  Build with `make debug` to have every
+ * request log its allocation count.
+ */
 
-/* Sentinel: no filtering (all workspaces) */
-#define WS_FILTER_NONE -999
+#define IPC_TIMEOUT_MS 1000
+#define IPC_CMD_MAX 512
+
+#ifdef SNAPPY_DEBUG
+static unsigned long ipc_alloc_count = 0; /* malloc/realloc on the IPC path */
+#define IPC_COUNT_ALLOC() (ipc_alloc_count++)
+#else
+#define IPC_COUNT_ALLOC() ((void)0)
+#endif
+
+typedef void (*IpcCallback)(char *resp, size_t len, void *user);
+
+typedef enum {
+  IPC_FREE,
+  IPC_CONNECTING,
+  IPC_WRITING,
+  IPC_READING
+} IpcPhase;
+
+typedef struct {
+  IpcPhase phase;
+  int fd;
+  char cmd[IPC_CMD_MAX];
+  size_t cmd_len;
+  size_t cmd_sent;
+  char *resp;      /* Retained across requests, freed in ipc_cleanup() */
+  size_t resp_len;
+  size_t resp_cap;
+  uint64_t deadline_ms;
+  IpcCallback cb;
+  void *user;
+#ifdef SNAPPY_DEBUG
+  unsigned long allocs_at_submit;
+#endif
+} IpcRequest;
+
+static IpcRequest ipc_requests[HYPRLAND_IPC_MAX_FDS];
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/* Release the slot, then run the callback (which may submit again; a new
+ * request only touches the response buffer once it starts reading, after
+ * the callback has returned) */
+static void ipc_complete(IpcRequest *r, bool ok) {
+  IpcCallback cb = r->cb;
+  void *user = r->user;
+  char *resp = r->resp;
+  size_t len = r->resp_len;
+
+#ifdef SNAPPY_DEBUG
+  LOG("IPC: '%s' done, %lu allocation(s)", r->cmd,
+      ipc_alloc_count - r->allocs_at_submit);
+#endif
+
+  if (r->fd >= 0)
+    close(r->fd);
+  r->fd = -1;
+  r->phase = IPC_FREE;
+  r->cb = NULL;
+  r->user = NULL;
+  r->resp_len = 0;
+
+  if (ok && resp)
+    resp[len] = '\0';
+  if (cb)
+    cb(ok ? resp : NULL, ok ? len : 0, user);
+}
 
 /*
- * Query Hyprland for the currently focused workspace ID.
- * Returns the integer workspace ID, or WS_FILTER_NONE on failure.
+ * Queue a request. Returns 0 if it is in flight (the callback will run
+ * exactly once, from hyprland_ipc_dispatch()), -1 if it could not be
+ * started (the callback is not called).
  */
-static int get_active_workspace_id(void) {
-  char *json_str = hyprland_request("j/activeworkspace");
-  if (!json_str) {
-    LOG("Failed to query active workspace");
-    return WS_FILTER_NONE;
+static int ipc_submit(const char *cmd, IpcCallback cb, void *user) {
+  IpcRequest *r = NULL;
+  for (int i = 0; i < HYPRLAND_IPC_MAX_FDS; i++) {
+    if (ipc_requests[i].phase == IPC_FREE) {
+      r = &ipc_requests[i];
+      break;
+    }
+  }
+  if (!r) {
+    LOG("IPC: too many requests in flight, dropping '%s'", cmd);
+    return -1;
   }
 
-  struct json_object *root = json_tokener_parse(json_str);
-  free(json_str);
+  size_t cmd_len = strlen(cmd);
+  if (cmd_len >= IPC_CMD_MAX) {
+    LOG("IPC: command too long (%zu bytes)", cmd_len);
+    return -1;
+  }
 
-  if (!root) {
-    LOG("Failed to parse active workspace JSON");
-    return WS_FILTER_NONE;
+#ifdef SNAPPY_DEBUG
+  r->allocs_at_submit = ipc_alloc_count;
+#endif
+
+  /* First use of this slot: allocate its response buffer */
+  if (!r->resp) {
+    r->resp = malloc(BUFFER_SIZE);
+    IPC_COUNT_ALLOC();
+    if (!r->resp)
+      return -1;
+    r->resp_cap = BUFFER_SIZE;
   }
 
-  struct json_object *id_obj;
-  int ws_id = WS_FILTER_NONE;
-  if (json_object_object_get_ex(root, "id", &id_obj)) {
-    ws_id = json_object_get_int(id_obj);
-    LOG("Active workspace: %d", ws_id);
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+
+  IpcPhase phase = IPC_WRITING;
+  if (connect(fd, (struct sockaddr *)&ipc_addr, sizeof(ipc_addr)) < 0) {
+    if (errno != EINPROGRESS) {
+      LOG("IPC: connect failed: %s", strerror(errno));
+      close(fd);
+      return -1;
+    }
+    phase = IPC_CONNECTING;
   }
 
-  json_object_put(root);
-  return ws_id;
+  r->phase = phase;
+  r->fd = fd;
+  memcpy(r->cmd, cmd, cmd_len + 1);
+  r->cmd_len = cmd_len;
+  r->cmd_sent = 0;
+  r->resp_len = 0;
+  r->deadline_ms = now_ms() + IPC_TIMEOUT_MS;
+  r->cb = cb;
+  r->user = user;
+  return 0;
 }
 
-/* --- JSON Parsing --- */
+/* Make as much progress as the socket allows without blocking */
+static void ipc_advance(IpcRequest *r, short revents) {
+  if (r->phase == IPC_CONNECTING) {
+    if (!(revents & (POLLOUT | POLLERR | POLLHUP)))
+      return;
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    if (getsockopt(r->fd, SOL_SOCKET, SO_ERROR, &err, &err_len) < 0 || err) {
+      LOG("IPC: connect failed: %s", strerror(err ? err : errno));
+      ipc_complete(r, false);
+      return;
+    }
+    r->phase = IPC_WRITING;
+  }
 
-/*
- * Parse the Hyprland client list JSON into AppState.
+  if (r->phase == IPC_WRITING) {
+    while (r->cmd_sent < r->cmd_len) {
+      ssize_t w =
+          write(r->fd, r->cmd + r->cmd_sent, r->cmd_len - r->cmd_sent);
+      if (w < 0) {
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return;
+        ipc_complete(r, false);
+        return;
+      }
+      r->cmd_sent += (size_t)w;
+    }
+    r->phase = IPC_READING;
+    return; /* Reply cannot be there yet — wait for POLLIN */
+  }
+
+  if (r->phase == IPC_READING) {
+    while (1) {
+      if (r->resp_len >= r->resp_cap - 1) {
+        /* Grows to the high-water mark once, then stays there */
+        char *tmp = realloc(r->resp, r->resp_cap * 2);
+        IPC_COUNT_ALLOC();
+        if (!tmp) {
+          ipc_complete(r, false);
+          return;
+        }
+        r->resp = tmp;
+        r->resp_cap *= 2;
+      }
+      ssize_t n = read(r->fd, r->resp + r->resp_len,
+                       r->resp_cap - r->resp_len - 1);
+      if (n < 0) {
+        if (errno == EINTR)
+          continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+          return;
+        ipc_complete(r, false);
+        return;
+      }
+      if (n == 0) {
+        /* Hyprland closes the connection once the reply is complete */
+        ipc_complete(r, true);
+        return;
+      }
+      r->resp_len += (size_t)n;
+    }
+  }
+}
+
+int hyprland_ipc_pollfds(struct pollfd *fds, int max) {
+  int n = 0;
+  for (int i = 0; i < HYPRLAND_IPC_MAX_FDS && n < max; i++) {
+    IpcRequest *r = &ipc_requests[i];
+    if (r->phase == IPC_FREE)
+      continue;
+    fds[n].fd = r->fd;
+    fds[n].events = (r->phase == IPC_READING) ? POLLIN : POLLOUT;
+    fds[n].revents = 0;
+    n++;
+  }
+  return n;
+}
+
+void hyprland_ipc_dispatch(const struct pollfd *fds, int count) {
+  for (int i = 0; i < count; i++) {
+    if (!fds[i].revents)
+      continue;
+    /* Match by fd: callbacks run in here may have reused earlier slots */
+    for (int j = 0; j < HYPRLAND_IPC_MAX_FDS; j++) {
+      IpcRequest *r = &ipc_requests[j];
+      if (r->phase != IPC_FREE && r->fd == fds[i].fd) {
+        ipc_advance(r, fds[i].revents);
+        break;
+      }
+    }
+  }
+
+  /* Deadlines: a stalled compositor costs us a log line, not a freeze */
+  uint64_t now = now_ms();
+  for (int j = 0; j < HYPRLAND_IPC_MAX_FDS; j++) {
+    IpcRequest *r = &ipc_requests[j];
+    if (r->phase != IPC_FREE && now >= r->deadline_ms) {
+      LOG("IPC: '%s' timed out after %d ms", r->cmd, IPC_TIMEOUT_MS);
+      ipc_complete(r, false);
+    }
+  }
+}
+
+/* Cancel everything in flight and release the retained buffers */
+static void ipc_cleanup(void) {
+  for (int j = 0; j < HYPRLAND_IPC_MAX_FDS; j++) {
+    IpcRequest *r = &ipc_requests[j];
+    if (r->phase != IPC_FREE) {
+      r->cb = NULL;
+      ipc_complete(r, false);
+    }
+    free(r->resp);
+    r->resp = NULL;
+    r->resp_cap = 0;
+  }
+}
+
+/* --- Window Model ---
+ *
+ * The daemon keeps its own copy of the compositor's window list.  It is
+ * seeded once from j/clients and then kept current by the events Hyprland
+ * writes to .socket2.sock, so showing the switcher needs no IPC at all.
+ * A full resync only happens at startup and after the event stream breaks
+ * (disconnect, overflow, or an event we cannot reconcile).
  *
- * target_ws: if != WS_FILTER_NONE, only include windows whose
- *            workspace.id matches this value.  Special workspaces
- *            (id == -1) are always excluded regardless.
+ * Windows live in stable slots and are threaded onto two indices that are
+ * maintained as events arrive, so a snapshot is a linear walk, never a
+ * sort:
+ *   - an intrusive doubly-linked MRU list (O(1) move-to-front per focus)
+ *   - a sorted array of slots ordered by (workspace_id, address) for
+ *     linear mode (binary-search insert/remove on open/close/move)
  */
-static int parse_clients(const char *json_str, AppState *state, int target_ws) {
-  struct json_object *root = json_tokener_parse(json_str);
-  if (!root || !json_object_is_type(root, json_type_array)) {
-    if (root)
-      json_object_put(root);
+
+typedef struct {
+  uint64_t addr;         /* Window address (parsed from hex) */
+  char *title;
+  char *class_name;
+  int workspace_id;
+  char *workspace_name;
+  bool is_floating;
+  bool used;             /* Slot holds a live window */
+  int mru_prev;          /* MRU neighbours (slot index, -1 = none) */
+  int mru_next;          /* Also chains free slots */
+  int mru_rank;          /* Scratch: position in MRU order at snapshot */
+} HyprWindow;
+
+/* Workspace name -> id, needed because openwindow only carries the name */
+typedef struct {
+  int id;
+  char *name;
+} HyprWorkspace;
+
+static struct {
+  HyprWindow *windows;
+  int slots;    /* High-water mark of used slots */
+  int capacity;
+  int live;     /* Number of windows */
+  int free_head;
+
+  int mru_head; /* Most recently focused */
+  int mru_tail;
+  int *linear;  /* live slot indices sorted by (workspace_id, addr) */
+
+  HyprWorkspace *workspaces;
+  int ws_count;
+  int ws_capacity;
+
+  uint64_t active_addr;   /* Currently focused window (0 = none) */
+  int active_ws;          /* Currently focused workspace */
+  bool synced;            /* Model is trustworthy without a resync */
+  unsigned generation;    /* Bumped by model_invalidate() */
+} model = {.free_head = -1, .mru_head = -1, .mru_tail = -1,
+           .active_ws = WS_FILTER_NONE};
+
+/* Event stream connection */
+static int event_fd = -1;
+static char event_buf[EVENT_BUFFER_SIZE];
+static size_t event_len = 0;
+
+/* Parse a Hyprland window address. Accepts both the "0x..." form used by
+ * j/clients and the bare hex form used by socket2 events. */
+static uint64_t parse_address(const char *str) {
+  if (!str || !*str)
+    return 0;
+  return (uint64_t)strtoull(str, NULL, 16);
+}
+
+static HyprWindow *model_find(uint64_t addr) {
+  for (int i = 0; i < model.slots; i++) {
+    if (model.windows[i].used && model.windows[i].addr == addr)
+      return &model.windows[i];
+  }
+  return NULL;
+}
+
+static int slot_of(const HyprWindow *w) { return (int)(w - model.windows); }
+
+/* Replace an owned string field in place */
+static void replace_str(char **field, const char *value) {
+  char *dup = strdup(value ? value : "");
+  if (!dup)
+    return; /* Keep the stale value rather than losing it */
+  free(*field);
+  *field = dup;
+}
+
+/* MRU list */
+
+static void mru_unlink(int i) {
+  HyprWindow *w = &model.windows[i];
+  if (w->mru_prev >= 0)
+    model.windows[w->mru_prev].mru_next = w->mru_next;
+  else
+    model.mru_head = w->mru_next;
+  if (w->mru_next >= 0)
+    model.windows[w->mru_next].mru_prev = w->mru_prev;
+  else
+    model.mru_tail = w->mru_prev;
+  w->mru_prev = w->mru_next = -1;
+}
+
+static void mru_push_front(int i) {
+  HyprWindow *w = &model.windows[i];
+  w->mru_prev = -1;
+  w->mru_next = model.mru_head;
+  if (model.mru_head >= 0)
+    model.windows[model.mru_head].mru_prev = i;
+  else
+    model.mru_tail = i;
+  model.mru_head = i;
+}
+
+static void mru_push_back(int i) {
+  HyprWindow *w = &model.windows[i];
+  w->mru_next = -1;
+  w->mru_prev = model.mru_tail;
+  if (model.mru_tail >= 0)
+    model.windows[model.mru_tail].mru_next = i;
+  else
+    model.mru_head = i;
+  model.mru_tail = i;
+}
+
+/* Linear index */
+
+static int linear_cmp(int a, int b) {
+  const HyprWindow *wa = &model.windows[a];
+  const HyprWindow *wb = &model.windows[b];
+  if (wa->workspace_id != wb->workspace_id)
+    return wa->workspace_id < wb->workspace_id ? -1 : 1;
+  if (wa->addr != wb->addr)
+    return wa->addr < wb->addr ? -1 : 1;
+  return 0;
+}
+
+/* First position whose entry does not sort before slot i */
+static int linear_lower_bound(int i) {
+  int lo = 0, hi = model.live;
+  while (lo < hi) {
+    int mid = (lo + hi) / 2;
+    if (linear_cmp(model.linear[mid], i) < 0)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return lo;
+}
+
+/* Insert slot i; model.live must not include it yet */
+static void linear_insert(int i) {
+  int pos = linear_lower_bound(i);
+  memmove(&model.linear[pos + 1], &model.linear[pos],
+          (model.live - pos) * sizeof(int));
+  model.linear[pos] = i;
+}
+
+/* Remove slot i; its key must be the one it was inserted with */
+static void linear_remove(int i) {
+  int pos = linear_lower_bound(i);
+  if (pos >= model.live || model.linear[pos] != i)
+    return;
+  memmove(&model.linear[pos], &model.linear[pos + 1],
+          (model.live - pos - 1) * sizeof(int));
+}
+
+static int linear_cmp_qsort(const void *a, const void *b) {
+  return linear_cmp(*(const int *)a, *(const int *)b);
+}
+
+/* Slots */
+
+/* Claim a slot for a new window. It is not on either index yet. */
+static HyprWindow *model_alloc(uint64_t addr) {
+  int i;
+  if (model.free_head >= 0) {
+    i = model.free_head;
+    model.free_head = model.windows[i].mru_next;
+  } else {
+    if (model.slots >= model.capacity) {
+      int new_cap = model.capacity == 0 ? INITIAL_CAPACITY : model.capacity * 2;
+      HyprWindow *new_ptr =
+          realloc(model.windows, new_cap * sizeof(HyprWindow));
+      if (!new_ptr)
+        return NULL;
+      model.windows = new_ptr;
+      int *new_linear = realloc(model.linear, new_cap * sizeof(int));
+      if (!new_linear)
+        return NULL;
+      model.linear = new_linear;
+      model.capacity = new_cap;
+    }
+    i = model.slots++;
+  }
+  HyprWindow *w = &model.windows[i];
+  memset(w, 0, sizeof(HyprWindow));
+  w->addr = addr;
+  w->used = true;
+  w->mru_prev = w->mru_next = -1;
+  return w;
+}
+
+/* Add a window opened while the model is live: least recent until focused */
+static HyprWindow *model_add(uint64_t addr, int workspace_id) {
+  HyprWindow *w = model_alloc(addr);
+  if (!w)
+    return NULL;
+  w->workspace_id = workspace_id;
+  int i = slot_of(w);
+  linear_insert(i);
+  model.live++;
+  mru_push_back(i);
+  return w;
+}
+
+static void model_set_workspace(HyprWindow *w, int workspace_id) {
+  if (w->workspace_id == workspace_id)
+    return;
+  int i = slot_of(w);
+  linear_remove(i);
+  model.live--;
+  w->workspace_id = workspace_id;
+  linear_insert(i);
+  model.live++;
+}
+
+static void model_remove(uint64_t addr) {
+  HyprWindow *w = model_find(addr);
+  if (w) {
+    int i = slot_of(w);
+    linear_remove(i);
+    model.live--;
+    mru_unlink(i);
+    free(w->title);
+    free(w->class_name);
+    free(w->workspace_name);
+    memset(w, 0, sizeof(HyprWindow));
+    w->mru_prev = -1;
+    w->mru_next = model.free_head;
+    model.free_head = i;
+  }
+  if (model.active_addr == addr)
+    model.active_addr = 0;
+}
+
+static void model_focus(uint64_t addr) {
+  model.active_addr = addr;
+  HyprWindow *w = model_find(addr);
+  if (w) {
+    int i = slot_of(w);
+    if (model.mru_head != i) {
+      mru_unlink(i);
+      mru_push_front(i);
+    }
+  }
+}
+
+/*
+ * Rebuild both indices after a bulk load.  `focus_ids` holds each slot's
+ * focusHistoryID; this is the one place ordering needs a sort, and it
+ * only runs on resync.
+ */
+static int model_reindex(const int *focus_ids) {
+  int n = model.slots;
+  int *order = malloc((n ? n : 1) * sizeof(int));
+  if (!order)
     return -1;
+
+  /* focusHistoryID is normally a permutation of 0..n-1: bucket it, and
+   * append any duplicates / out-of-range IDs in slot order afterwards. */
+  for (int i = 0; i < n; i++)
+    order[i] = -1;
+  model.mru_head = model.mru_tail = -1;
+  for (int i = 0; i < n; i++) {
+    int f = focus_ids[i];
+    if (f >= 0 && f < n && order[f] < 0)
+      order[f] = i;
+  }
+  for (int f = 0; f < n; f++) {
+    if (order[f] >= 0)
+      mru_push_back(order[f]);
   }
+  for (int i = 0; i < n; i++) {
+    int f = focus_ids[i];
+    if (!(f >= 0 && f < n && order[f] == i))
+      mru_push_back(i);
+  }
+  free(order);
 
-  size_t len = json_object_array_length(root);
-  for (size_t i = 0; i < len; i++) {
-    struct json_object *obj = json_object_array_get_idx(root, i);
-    struct json_object *ws_obj = NULL, *ws_id = NULL, *ws_name = NULL,
-                       *addr = NULL, *title = NULL, *cls = NULL,
-                       *focus = NULL, *floating = NULL;
+  for (int i = 0; i < n; i++)
+    model.linear[i] = i;
+  model.live = n;
+  qsort(model.linear, n, sizeof(int), linear_cmp_qsort);
+  return 0;
+}
 
-    if (!json_object_object_get_ex(obj, "workspace", &ws_obj))
-      continue;
-    if (!json_object_object_get_ex(ws_obj, "id", &ws_id))
-      continue;
+static HyprWorkspace *workspace_find_id(int id) {
+  for (int i = 0; i < model.ws_count; i++) {
+    if (model.workspaces[i].id == id)
+      return &model.workspaces[i];
+  }
+  return NULL;
+}
 
-    int wid = json_object_get_int(ws_id);
+/* Record (or rename) a workspace in the name -> id table */
+static void workspace_learn(int id, const char *name) {
+  if (!name)
+    return;
+  HyprWorkspace *ws = workspace_find_id(id);
+  if (ws) {
+    if (strcmp(ws->name, name) != 0)
+      replace_str(&ws->name, name);
+    return;
+  }
+  if (model.ws_count >= model.ws_capacity) {
+    int new_cap = model.ws_capacity == 0 ? 16 : model.ws_capacity * 2;
+    HyprWorkspace *new_ptr =
+        realloc(model.workspaces, new_cap * sizeof(HyprWorkspace));
+    if (!new_ptr)
+      return;
+    model.workspaces = new_ptr;
+    model.ws_capacity = new_cap;
+  }
+  char *dup = strdup(name);
+  if (!dup)
+    return;
+  model.workspaces[model.ws_count].id = id;
+  model.workspaces[model.ws_count].name = dup;
+  model.ws_count++;
+}
 
-    /* Always skip special workspaces (id == -1) */
-    if (wid == -1)
+static void workspace_forget(int id) {
+  for (int i = 0; i < model.ws_count; i++) {
+    if (model.workspaces[i].id == id) {
+      free(model.workspaces[i].name);
+      model.workspaces[i] = model.workspaces[--model.ws_count];
+      return;
+    }
+  }
+}
+
+/* Resolve a workspace name to its id. Returns false if unknown. */
+static bool workspace_lookup_name(const char *name, int *id_out) {
+  for (int i = 0; i < model.ws_count; i++) {
+    if (strcmp(model.workspaces[i].name, name) == 0) {
+      *id_out = model.workspaces[i].id;
+      return true;
+    }
+  }
+  return false;
+}
+
+/* The model missed something it cannot reconstruct: resync soon */
+static void model_invalidate(void) {
+  model.synced = false;
+  model.generation++;
+}
+
+static void model_clear(void) {
+  for (int i = 0; i < model.slots; i++) {
+    HyprWindow *w = &model.windows[i];
+    if (w->used) {
+      free(w->title);
+      free(w->class_name);
+      free(w->workspace_name);
+    }
+  }
+  free(model.windows);
+  model.windows = NULL;
+  free(model.linear);
+  model.linear = NULL;
+  model.slots = 0;
+  model.capacity = 0;
+  model.live = 0;
+  model.free_head = -1;
+  model.mru_head = -1;
+  model.mru_tail = -1;
+
+  for (int i = 0; i < model.ws_count; i++)
+    free(model.workspaces[i].name);
+  free(model.workspaces);
+  model.workspaces = NULL;
+  model.ws_count = 0;
+  model.ws_capacity = 0;
+
+  model.active_addr = 0;
+  model.active_ws = WS_FILTER_NONE;
+  model.synced = false;
+}
+
+/* --- JSON Parsing ---
+ *
+ * j/clients carries a dozen fields per window we never look at (at, size,
+ * pid, grouped, swallowing, ...).  Rather than building a full json-c tree
+ * for it, this small scanner walks the text once, skips everything it does
+ * not need, and decodes the few strings it keeps in place inside the
+ * response buffer (an unescaped string is never longer than its source).
+ */
+
+typedef struct {
+  char *p;   /* Read cursor */
+  char *end; /* One past the last byte */
+} JsonScan;
+
+static void js_skip_ws(JsonScan *s) {
+  while (s->p < s->end &&
+         (*s->p == ' ' || *s->p == '\n' || *s->p == '\r' || *s->p == '\t'))
+    s->p++;
+}
+
+/* Consume `c` (after optional whitespace). Returns false if not present. */
+static bool js_expect(JsonScan *s, char c) {
+  js_skip_ws(s);
+  if (s->p < s->end && *s->p == c) {
+    s->p++;
+    return true;
+  }
+  return false;
+}
+
+static int hex_value(char c) {
+  if (c >= '0' && c <= '9')
+    return c - '0';
+  if (c >= 'a' && c <= 'f')
+    return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+static bool js_read_hex4(JsonScan *s, unsigned *out) {
+  if (s->end - s->p < 4)
+    return false;
+  unsigned v = 0;
+  for (int i = 0; i < 4; i++) {
+    int h = hex_value(s->p[i]);
+    if (h < 0)
+      return false;
+    v = (v << 4) | (unsigned)h;
+  }
+  s->p += 4;
+  *out = v;
+  return true;
+}
+
+/* Encode a code point as UTF-8 at *w (at most 4 bytes) */
+static void put_utf8(char **w, unsigned cp) {
+  unsigned char *o = (unsigned char *)*w;
+  if (cp < 0x80) {
+    *o++ = (unsigned char)cp;
+  } else if (cp < 0x800) {
+    *o++ = (unsigned char)(0xC0 | (cp >> 6));
+    *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+  } else if (cp < 0x10000) {
+    *o++ = (unsigned char)(0xE0 | (cp >> 12));
+    *o++ = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+    *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+  } else {
+    *o++ = (unsigned char)(0xF0 | (cp >> 18));
+    *o++ = (unsigned char)(0x80 | ((cp >> 12) & 0x3F));
+    *o++ = (unsigned char)(0x80 | ((cp >> 6) & 0x3F));
+    *o++ = (unsigned char)(0x80 | (cp & 0x3F));
+  }
+  *w = (char *)o;
+}
+
+/*
+ * Decode a JSON string in place. On success *out points at the
+ * NUL-terminated result, which lives inside the scanned buffer.
+ */
+static bool js_string(JsonScan *s, char **out) {
+  if (!js_expect(s, '"'))
+    return false;
+
+  char *start = s->p;
+  char *w = s->p;
+  while (s->p < s->end) {
+    char c = *s->p++;
+    if (c == '"') {
+      *w = '\0'; /* w <= closing quote, so this never clobbers unread input */
+      *out = start;
+      return true;
+    }
+    if (c != '\\') {
+      *w++ = c;
       continue;
+    }
+    if (s->p >= s->end)
+      return false;
+    char e = *s->p++;
+    switch (e) {
+    case '"':  *w++ = '"';  break;
+    case '\\': *w++ = '\\'; break;
+    case '/':  *w++ = '/';  break;
+    case 'b':  *w++ = '\b'; break;
+    case 'f':  *w++ = '\f'; break;
+    case 'n':  *w++ = '\n'; break;
+    case 'r':  *w++ = '\r'; break;
+    case 't':  *w++ = '\t'; break;
+    case 'u': {
+      unsigned cp;
+      if (!js_read_hex4(s, &cp))
+        return false;
+      /* Surrogate pair (e.g. \ud83d\ude00) -> one 4-byte sequence */
+      if (cp >= 0xD800 && cp <= 0xDBFF && s->end - s->p >= 6 &&
+          s->p[0] == '\\' && s->p[1] == 'u') {
+        JsonScan peek = {s->p + 2, s->end};
+        unsigned lo;
+        if (js_read_hex4(&peek, &lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+          s->p = peek.p;
+        }
+      }
+      if (cp >= 0xD800 && cp <= 0xDFFF)
+        cp = 0xFFFD; /* Lone surrogate */
+      put_utf8(&w, cp);
+      break;
+    }
+    default:
+      return false;
+    }
+  }
+  return false; /* Unterminated */
+}
 
-    /* Workspace filter: skip windows not on the target workspace */
-    if (target_ws != WS_FILTER_NONE && wid != target_ws)
+/* Skip one value of any type, including nested containers */
+static bool js_skip_value(JsonScan *s) {
+  js_skip_ws(s);
+  if (s->p >= s->end)
+    return false;
+
+  if (*s->p == '"') {
+    /* Skip without decoding */
+    s->p++;
+    while (s->p < s->end) {
+      char c = *s->p++;
+      if (c == '\\')
+        s->p++;
+      else if (c == '"')
+        return s->p <= s->end;
+    }
+    return false;
+  }
+
+  if (*s->p == '{' || *s->p == '[') {
+    int depth = 0;
+    while (s->p < s->end) {
+      char c = *s->p;
+      if (c == '"') {
+        if (!js_skip_value(s))
+          return false;
+        continue;
+      }
+      s->p++;
+      if (c == '{' || c == '[') {
+        depth++;
+      } else if (c == '}' || c == ']') {
+        if (--depth == 0)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  /* Number / true / false / null */
+  char *start = s->p;
+  while (s->p < s->end && *s->p != ',' && *s->p != '}' && *s->p != ']' &&
+         *s->p != ' ' && *s->p != '\n' && *s->p != '\r' && *s->p != '\t')
+    s->p++;
+  return s->p > start;
+}
+
+static bool js_int(JsonScan *s, int *out) {
+  js_skip_ws(s);
+  char *endp;
+  long v = strtol(s->p, &endp, 10);
+  if (endp == s->p)
+    return js_skip_value(s); /* Not a number (e.g. null): leave default */
+  *out = (int)v;
+  s->p = endp;
+  /* Tolerate fractional/exponent forms */
+  while (s->p < s->end && (*s->p == '.' || *s->p == 'e' || *s->p == 'E' ||
+                           *s->p == '+' || *s->p == '-' ||
+                           (*s->p >= '0' && *s->p <= '9')))
+    s->p++;
+  return true;
+}
+
+static bool js_bool(JsonScan *s, bool *out) {
+  js_skip_ws(s);
+  if (s->end - s->p >= 4 && strncmp(s->p, "true", 4) == 0) {
+    *out = true;
+    s->p += 4;
+    return true;
+  }
+  if (s->end - s->p >= 5 && strncmp(s->p, "false", 5) == 0) {
+    *out = false;
+    s->p += 5;
+    return true;
+  }
+  return js_skip_value(s);
+}
+
+/*
+ * Iterate the members of an object. Call with the cursor before '{' and
+ * *first = true; returns the next key (decoded in place) with the cursor
+ * before its value, or NULL at the end of the object / on error.
+ */
+static char *js_next_key(JsonScan *s, bool *first, bool *error) {
+  if (*first) {
+    *first = false;
+    if (!js_expect(s, '{')) {
+      *error = true;
+      return NULL;
+    }
+    if (js_expect(s, '}'))
+      return NULL;
+  } else {
+    if (js_expect(s, '}'))
+      return NULL;
+    if (!js_expect(s, ',')) {
+      *error = true;
+      return NULL;
+    }
+  }
+
+  char *key;
+  if (!js_string(s, &key) || !js_expect(s, ':')) {
+    *error = true;
+    return NULL;
+  }
+  return key;
+}
+
+/* Fields we keep from one j/clients entry; strings point into the buffer
+ * until parse_clients() copies them for the model */
+typedef struct {
+  char *address;
+  char *title;
+  char *class_name;
+  char *workspace_name;
+  int workspace_id;
+  bool has_workspace;
+  int focus_history_id;
+  bool is_floating;
+} ClientFields;
+
+static bool scan_workspace(JsonScan *s, ClientFields *f) {
+  bool first = true, error = false;
+  char *key;
+  while ((key = js_next_key(s, &first, &error)) != NULL) {
+    bool ok;
+    if (strcmp(key, "id") == 0) {
+      ok = js_int(s, &f->workspace_id);
+      f->has_workspace = true;
+    } else if (strcmp(key, "name") == 0) {
+      ok = js_string(s, &f->workspace_name);
+    } else {
+      ok = js_skip_value(s);
+    }
+    if (!ok)
+      return false;
+  }
+  return !error;
+}
+
+static bool scan_client(JsonScan *s, ClientFields *f) {
+  bool first = true, error = false;
+  char *key;
+  while ((key = js_next_key(s, &first, &error)) != NULL) {
+    bool ok;
+    if (strcmp(key, "address") == 0)
+      ok = js_string(s, &f->address);
+    else if (strcmp(key, "title") == 0)
+      ok = js_string(s, &f->title);
+    else if (strcmp(key, "class") == 0)
+      ok = js_string(s, &f->class_name);
+    else if (strcmp(key, "workspace") == 0)
+      ok = scan_workspace(s, f);
+    else if (strcmp(key, "focusHistoryID") == 0)
+      ok = js_int(s, &f->focus_history_id);
+    else if (strcmp(key, "floating") == 0)
+      ok = js_bool(s, &f->is_floating);
+    else
+      ok = js_skip_value(s);
+    if (!ok)
+      return false;
+  }
+  return !error;
+}
+
+/*
+ * Parse a j/activeworkspace object and advance past it.
+ * Returns the workspace ID, or WS_FILTER_NONE on failure.
+ */
+static int parse_active_workspace(JsonScan *s) {
+  int ws_id = WS_FILTER_NONE;
+  bool first = true, error = false;
+  char *key;
+  while ((key = js_next_key(s, &first, &error)) != NULL) {
+    bool ok = (strcmp(key, "id") == 0) ? js_int(s, &ws_id) : js_skip_value(s);
+    if (!ok)
+      return WS_FILTER_NONE;
+  }
+  if (error) {
+    LOG("Failed to parse active workspace JSON");
+    return WS_FILTER_NONE;
+  }
+  LOG("Active workspace: %d", ws_id);
+  return ws_id;
+}
+
+/*
+ * Parse the Hyprland client list JSON into the window model, replacing
+ * its previous contents.  The buffer is modified (strings are decoded in
+ * place).  The whole list is scanned, and its strings copied, before the
+ * model is touched, so a truncated or malformed reply (or running out of
+ * memory for the copies) leaves the previous model in place.
+ * Workspace filtering is applied later, when a snapshot is taken, so the
+ * model always holds every window.
+ */
+/* Free the strings parse_clients() copied for entries [from, to) */
+static void clients_free_strings(ClientFields *clients, int from, int to) {
+  for (int i = from; i < to; i++) {
+    free(clients[i].title);
+    free(clients[i].class_name);
+    free(clients[i].workspace_name);
+  }
+}
+
+static int parse_clients(JsonScan *scan) {
+  JsonScan s = *scan;
+  if (!js_expect(&s, '['))
+    return -1;
+
+  ClientFields *clients = NULL;
+  int count = 0, cap = 0;
+  bool first = true;
+  while (1) {
+    if (js_expect(&s, ']'))
+      break;
+    ClientFields f = {.focus_history_id = -1};
+    if ((!first && !js_expect(&s, ',')) || !scan_client(&s, &f)) {
+      free(clients);
+      return -1;
+    }
+    first = false;
+    if (!f.has_workspace)
       continue;
 
-    json_object_object_get_ex(ws_obj, "name", &ws_name);
-    json_object_object_get_ex(obj, "address", &addr);
-    json_object_object_get_ex(obj, "title", &title);
-    json_object_object_get_ex(obj, "class", &cls);
-    json_object_object_get_ex(obj, "focusHistoryID", &focus);
-    json_object_object_get_ex(obj, "floating", &floating);
+    if (count == cap) {
+      int new_cap = cap ? cap * 2 : INITIAL_CAPACITY;
+      ClientFields *tmp = realloc(clients, new_cap * sizeof(ClientFields));
+      if (!tmp) {
+        free(clients);
+        return -1;
+      }
+      clients = tmp;
+      cap = new_cap;
+    }
+    clients[count++] = f;
+  }
 
-    WindowInfo info;
-    info.address = safe_strdup(json_object_get_string(addr));
-    info.title = safe_strdup(json_object_get_string(title));
-    info.class_name = safe_strdup(json_object_get_string(cls));
-    info.workspace_id = wid;
-    info.workspace_name = safe_strdup(ws_name ? json_object_get_string(ws_name) : "");
-    info.focus_history_id = focus ? json_object_get_int(focus) : 9999;
-    info.is_active = (info.focus_history_id == 0);
-    info.is_floating = floating ? json_object_get_boolean(floating) : false;
-    info.group_count = 1;
+  for (int i = 0; i < count; i++) {
+    ClientFields *f = &clients[i];
+    char *title = strdup(f->title ? f->title : "");
+    char *class_name = strdup(f->class_name ? f->class_name : "");
+    char *workspace_name =
+        strdup(f->workspace_name ? f->workspace_name : "");
+    if (!title || !class_name || !workspace_name) {
+      free(title);
+      free(class_name);
+      free(workspace_name);
+      clients_free_strings(clients, 0, i);
+      free(clients);
+      return -1;
+    }
+    f->title = title;
+    f->class_name = class_name;
+    f->workspace_name = workspace_name;
+  }
 
-    app_state_add(state, &info);
+  model_clear();
+
+  int *focus_ids = NULL;
+  int focus_cap = 0;
+  int i;
+  for (i = 0; i < count; i++) {
+    ClientFields *f = &clients[i];
+    HyprWindow *w = model_alloc(parse_address(f->address));
+    if (!w)
+      break;
+    if (model.slots > focus_cap) {
+      focus_cap = model.capacity;
+      int *tmp = realloc(focus_ids, focus_cap * sizeof(int));
+      if (!tmp) {
+        /* Undo the claim; the slot has no strings yet */
+        model.slots--;
+        break;
+      }
+      focus_ids = tmp;
+    }
+    focus_ids[slot_of(w)] = f->focus_history_id;
+    w->title = f->title; /* The model owns the copies now */
+    w->class_name = f->class_name;
+    w->workspace_id = f->workspace_id;
+    w->workspace_name = f->workspace_name;
+    w->is_floating = f->is_floating;
+    if (f->focus_history_id == 0)
+      model.active_addr = w->addr;
+
+    workspace_learn(w->workspace_id, w->workspace_name);
+  }
+  clients_free_strings(clients, i, count); /* Not taken by the model */
+  free(clients);
+
+  int rc = model_reindex(focus_ids);
+  free(focus_ids);
+  return rc;
+}
+
+/* --- Resync ---
+ * Full refresh of the window model.  Both queries go out as a single
+ * [[BATCH]] request through the async engine, so a resync costs one
+ * round trip.  At most one resync is in flight. */
+
+#define RESYNC_BATCH "[[BATCH]]j/activeworkspace;j/clients"
+
+static bool resync_in_flight = false;
+static unsigned resync_generation = 0;
+static struct timespec resync_started;
+static void (*windows_changed_cb)(void) = NULL;
+
+void hyprland_set_windows_changed_callback(void (*cb)(void)) {
+  windows_changed_cb = cb;
+}
+
+static void (*title_changed_cb)(uint64_t id) = NULL;
+
+void hyprland_set_title_changed_callback(void (*cb)(uint64_t id)) {
+  title_changed_cb = cb;
+}
+
+static void resync_done(bool ok) {
+  resync_in_flight = false;
+  if (!ok)
+    return;
+
+  /* Invalidated again while we were waiting: the reply may predate it */
+  if (model.generation != resync_generation) {
+    resync_model();
+    return;
   }
 
-  json_object_put(root);
+  /* Without a live event stream the model goes stale immediately, so keep
+   * it flagged for a resync on every show (the pre-event-socket behavior). */
+  model.synced = (event_fd >= 0);
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  LOG("Window model synced: %d windows in %.2f ms", model.live,
+      (now.tv_sec - resync_started.tv_sec) * 1e3 +
+          (now.tv_nsec - resync_started.tv_nsec) / 1e6);
+  if (windows_changed_cb)
+    windows_changed_cb();
+}
+
+/*
+ * Demultiplex the batch reply: the j/activeworkspace object, then the
+ * j/clients array (Hyprland separates batch replies with blank lines,
+ * which the scanner skips as whitespace).
+ */
+static void on_resync_reply(char *resp, size_t len, void *user) {
+  (void)user;
+  if (!resp) {
+    LOG("Resync failed: batch request failed");
+    resync_done(false);
+    return;
+  }
+
+  /* Found before parsing, which decodes strings in place (NULs) */
+  char *sep = memmem(resp, len, "\n\n\n", 3);
+
+  JsonScan s = {resp, resp + len};
+  int active_ws = parse_active_workspace(&s);
+  if (active_ws == WS_FILTER_NONE) {
+    /* No usable workspace reply (e.g. an error string): find the
+     * clients array after the batch separator instead. */
+    s.p = sep ? sep : resp + len;
+  }
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  if (parse_clients(&s) < 0) {
+    LOG("Resync failed: could not parse j/clients, keeping the old list");
+    resync_done(false);
+    return;
+  }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  LOG("Parsed %zu bytes of j/clients in %.3f ms", len,
+      (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+  model.active_ws = active_ws; /* After parse_clients(), which resets it */
+  resync_done(true);
+}
+
+static int resync_model(void) {
+  if (resync_in_flight)
+    return 0;
+  resync_generation = model.generation;
+  clock_gettime(CLOCK_MONOTONIC, &resync_started);
+  if (ipc_submit(RESYNC_BATCH, on_resync_reply, NULL) < 0) {
+    LOG("Resync failed: could not start batch request");
+    return -1;
+  }
+  resync_in_flight = true;
   return 0;
 }
 
-/* --- Aggregation (Context Mode) --- */
-static void aggregate_context(AppState *state) {
-  if (state->count <= 1)
+/* --- Event Stream (.socket2.sock) --- */
+
+static int events_connect(void) {
+  if (event_fd >= 0)
+    return 0;
+
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd < 0)
+    return -1;
+
+  if (connect(fd, (struct sockaddr *)&event_addr, sizeof(event_addr)) < 0) {
+    LOG("Failed to connect to event socket: %s", strerror(errno));
+    close(fd);
+    return -1;
+  }
+
+  /* Non-blocking: the fd is drained from the daemon's poll() loop */
+  int flags = fcntl(fd, F_GETFL, 0);
+  if (flags >= 0)
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+
+  event_fd = fd;
+  event_len = 0;
+  LOG("Subscribed to Hyprland event stream");
+  return 0;
+}
+
+static void events_disconnect(void) {
+  if (event_fd >= 0) {
+    close(event_fd);
+    event_fd = -1;
+  }
+  event_len = 0;
+}
+
+/* Split off the next comma-separated field. The last field of an event
+ * (usually a title) may itself contain commas, so callers read it as-is
+ * from *cursor instead of calling this again. */
+static char *next_field(char **cursor) {
+  char *start = *cursor;
+  if (!start)
+    return NULL;
+  char *comma = strchr(start, ',');
+  if (comma) {
+    *comma = '\0';
+    *cursor = comma + 1;
+  } else {
+    *cursor = NULL;
+  }
+  return start;
+}
+
+/* Apply a single "EVENT>>DATA" line to the model */
+static void handle_event(char *line) {
+  char *sep = strstr(line, ">>");
+  if (!sep)
     return;
+  *sep = '\0';
+  const char *event = line;
+  char *data = sep + 2;
+
+  if (strcmp(event, "openwindow") == 0) {
+    /* openwindow>>ADDRESS,WORKSPACENAME,CLASS,TITLE */
+    char *addr = next_field(&data);
+    char *ws_name = next_field(&data);
+    char *cls = next_field(&data);
+    const char *title = data ? data : "";
+    if (!addr || !ws_name || !cls)
+      return;
+
+    int ws_id;
+    if (!workspace_lookup_name(ws_name, &ws_id)) {
+      LOG("Window opened on unknown workspace '%s', scheduling resync",
+          ws_name);
+      model_invalidate();
+      return;
+    }
 
-  int count = state->count;
-  WindowInfo *out = malloc(count * sizeof(WindowInfo));
-  if (!out)
+    uint64_t a = parse_address(addr);
+    HyprWindow *w = model_find(a);
+    if (w)
+      model_set_workspace(w, ws_id);
+    else
+      w = model_add(a, ws_id);
+    if (!w) {
+      model_invalidate();
+      return;
+    }
+    replace_str(&w->title, title);
+    replace_str(&w->class_name, cls);
+    replace_str(&w->workspace_name, ws_name);
+  } else if (strcmp(event, "closewindow") == 0) {
+    /* closewindow>>ADDRESS */
+    model_remove(parse_address(data));
+  } else if (strcmp(event, "windowtitlev2") == 0) {
+    /* windowtitlev2>>ADDRESS,TITLE */
+    char *addr = next_field(&data);
+    HyprWindow *w = model_find(parse_address(addr));
+    if (w) {
+      replace_str(&w->title, data ? data : "");
+      if (title_changed_cb)
+        title_changed_cb(w->addr);
+    }
+  } else if (strcmp(event, "activewindowv2") == 0) {
+    /* activewindowv2>>ADDRESS (empty when nothing is focused) */
+    uint64_t a = parse_address(data);
+    if (a != 0 && !model_find(a)) {
+      LOG("Focus moved to unknown window %s, scheduling resync", data);
+      model_invalidate();
+      return;
+    }
+    model_focus(a);
+  } else if (strcmp(event, "movewindowv2") == 0) {
+    /* movewindowv2>>ADDRESS,WORKSPACEID,WORKSPACENAME */
+    char *addr = next_field(&data);
+    char *ws_id = next_field(&data);
+    if (!addr || !ws_id || !data)
+      return;
+    int id = atoi(ws_id);
+    workspace_learn(id, data);
+    HyprWindow *w = model_find(parse_address(addr));
+    if (w) {
+      model_set_workspace(w, id);
+      replace_str(&w->workspace_name, data);
+    }
+  } else if (strcmp(event, "changefloatingmode") == 0) {
+    /* changefloatingmode>>ADDRESS,FLOATING */
+    char *addr = next_field(&data);
+    HyprWindow *w = model_find(parse_address(addr));
+    if (w && data)
+      w->is_floating = (atoi(data) != 0);
+  } else if (strcmp(event, "workspacev2") == 0 ||
+             strcmp(event, "createworkspacev2") == 0) {
+    /* workspacev2>>ID,NAME / createworkspacev2>>ID,NAME */
+    char *ws_id = next_field(&data);
+    if (!ws_id || !data)
+      return;
+    int id = atoi(ws_id);
+    workspace_learn(id, data);
+    if (event[0] == 'w')
+      model.active_ws = id;
+  } else if (strcmp(event, "focusedmonv2") == 0) {
+    /* focusedmonv2>>MONNAME,WORKSPACEID — focusing another monitor
+     * changes the active workspace without a workspacev2 event */
+    next_field(&data);
+    if (data)
+      model.active_ws = atoi(data);
+  } else if (strcmp(event, "renameworkspace") == 0) {
+    /* renameworkspace>>ID,NEWNAME */
+    char *ws_id = next_field(&data);
+    if (!ws_id || !data)
+      return;
+    int id = atoi(ws_id);
+    workspace_learn(id, data);
+    for (int i = 0; i < model.slots; i++) {
+      if (model.windows[i].used && model.windows[i].workspace_id == id)
+        replace_str(&model.windows[i].workspace_name, data);
+    }
+  } else if (strcmp(event, "destroyworkspacev2") == 0) {
+    /* destroyworkspacev2>>ID,NAME */
+    char *ws_id = next_field(&data);
+    if (ws_id)
+      workspace_forget(atoi(ws_id));
+  }
+}
+
+int hyprland_get_event_fd(void) { return event_fd; }
+
+void hyprland_dispatch_events(void) {
+  if (event_fd < 0)
     return;
-  int out_count = 0;
 
-  for (int i = 0; i < count; i++) {
-    WindowInfo *win = &state->windows[i];
-
-    if (win->is_floating) {
-      out[out_count].address = safe_strdup(win->address);
-      out[out_count].title = safe_strdup(win->title);
-      out[out_count].class_name = safe_strdup(win->class_name);
-      out[out_count].workspace_id = win->workspace_id;
-      out[out_count].workspace_name = safe_strdup(win->workspace_name);
-      out[out_count].focus_history_id = win->focus_history_id;
-      out[out_count].is_active = win->is_active;
-      out[out_count].is_floating = true;
-      out[out_count].group_count = 1;
-      out_count++;
-    } else {
-      int found = -1;
-      for (int j = 0; j < out_count; j++) {
-        if (!out[j].is_floating && out[j].workspace_id == win->workspace_id &&
-            strcmp(out[j].class_name, win->class_name) == 0) {
-          found = j;
+  bool stream_lost = false;
+  while (1) {
+    if (event_len >= sizeof(event_buf) - 1) {
+      /* A single event overflowed the buffer: we can no longer tell where
+       * the next one starts, so drop everything and resync. */
+      LOG("Event buffer overflow, scheduling resync");
+      event_len = 0;
+      model_invalidate();
+    }
+
+    ssize_t n = read(event_fd, event_buf + event_len,
+                     sizeof(event_buf) - 1 - event_len);
+    if (n < 0) {
+      if (errno == EINTR)
+        continue;
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        LOG("Event socket read error: %s", strerror(errno));
+        stream_lost = true;
+      }
+      break;
+    }
+    if (n == 0) {
+      LOG("Event socket closed by compositor");
+      stream_lost = true;
+      break;
+    }
+    event_len += (size_t)n;
+    event_buf[event_len] = '\0';
+
+    /* Apply every complete line, keep the partial tail for the next read */
+    char *line = event_buf;
+    char *nl;
+    while ((nl = strchr(line, '\n')) != NULL) {
+      *nl = '\0';
+      handle_event(line);
+      line = nl + 1;
+    }
+    size_t consumed = (size_t)(line - event_buf);
+    memmove(event_buf, line, event_len - consumed);
+    event_len -= consumed;
+  }
+
+  if (stream_lost) {
+    /* Events were (or may have been) lost — reconnect first so nothing
+     * falls between the new subscription and the snapshot. */
+    events_disconnect();
+    model_invalidate();
+    events_connect();
+  }
+
+  if (!model.synced)
+    resync_model();
+}
+
+/* --- Aggregation (Context Mode) ---
+ * One pass over the sorted windows with an open-addressing table keyed by
+ * (workspace_id, class).  Tiled windows sharing a key collapse into one
+ * card that keeps its first (most recent) member's WindowInfo; floating
+ * windows always get a card of their own.  Strings stay in the arena, so
+ * nothing is copied.  The pre-aggregation list is kept in state->members,
+ * with each card's member indices stored contiguously in
+ * state->group_members[member_offset .. member_offset + group_count). */
+
+typedef struct {
+  uint32_t hash; /* 0 = empty slot */
+  int group;     /* Index of the card in state->windows */
+} GroupSlot;
+
+static uint32_t hash_str(const char *str) {
+  uint32_t h = 2166136261u; /* FNV-1a */
+  for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+    h = (h ^ *p) * 16777619u;
+  return h;
+}
+
+static void aggregate_context(AppState *state) {
+  int n = state->count;
+  if (n == 0)
+    return;
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  size_t table_size = 16;
+  while (table_size < (size_t)n * 2)
+    table_size *= 2;
+
+  WindowInfo *members = malloc(n * sizeof(WindowInfo));
+  int *group_members = malloc(n * sizeof(int));
+  /* Scratch: group of each window, per-group fill cursor, hash table */
+  int *group_of = malloc(2 * n * sizeof(int) + table_size * sizeof(GroupSlot));
+  if (!members || !group_members || !group_of) {
+    free(members);
+    free(group_members);
+    free(group_of);
+    return; /* Show ungrouped rather than nothing */
+  }
+  int *cursor = group_of + n;
+  GroupSlot *table = (GroupSlot *)(cursor + n);
+  memset(table, 0, table_size * sizeof(GroupSlot));
+  memcpy(members, state->windows, n * sizeof(WindowInfo));
+
+  int groups = 0;
+  for (int i = 0; i < n; i++) {
+    WindowInfo *win = &members[i];
+    int g = -1;
+    GroupSlot *slot = NULL;
+
+    if (!win->is_floating) {
+      uint32_t h = hash_str(win->class_name) ^
+                   ((uint32_t)win->workspace_id * 2654435761u);
+      if (h == 0)
+        h = 1;
+      size_t mask = table_size - 1;
+      for (size_t k = h & mask;; k = (k + 1) & mask) {
+        if (table[k].hash == 0) {
+          slot = &table[k];
+          slot->hash = h;
+          break;
+        }
+        WindowInfo *o = &state->windows[table[k].group];
+        if (table[k].hash == h && o->workspace_id == win->workspace_id &&
+            strcmp(o->class_name, win->class_name) == 0) {
+          g = table[k].group;
           break;
         }
       }
+    }
 
-      if (found >= 0) {
-        out[found].group_count++;
-      } else {
-        out[out_count].address = safe_strdup(win->address);
-        out[out_count].title = safe_strdup(win->title);
-        out[out_count].class_name = safe_strdup(win->class_name);
-        out[out_count].workspace_id = win->workspace_id;
-        out[out_count].workspace_name = safe_strdup(win->workspace_name);
-        out[out_count].focus_history_id = win->focus_history_id;
-        out[out_count].is_active = win->is_active;
-        out[out_count].is_floating = false;
-        out[out_count].group_count = 1;
-        out_count++;
-      }
+    if (g >= 0) {
+      state->windows[g].group_count++;
+    } else {
+      /* groups <= i, and members[] holds the originals, so this is safe */
+      g = groups++;
+      state->windows[g] = *win;
+      state->windows[g].group_count = 1;
+      if (slot)
+        slot->group = g;
     }
+    group_of[i] = g;
   }
 
-  for (int i = 0; i < count; i++)
-    window_info_free(&state->windows[i]);
-  free(state->windows);
-
-  state->windows = out;
-  state->count = out_count;
-  state->capacity = count;
+  /* Lay out member lists contiguously, in MRU order within each group */
+  int offset = 0;
+  for (int g = 0; g < groups; g++) {
+    state->windows[g].member_offset = offset;
+    cursor[g] = offset;
+    offset += state->windows[g].group_count;
+  }
+  for (int i = 0; i < n; i++)
+    group_members[cursor[group_of[i]]++] = i;
+  free(group_of);
+
+  free(state->members);
+  free(state->group_members);
+  state->members = members;
+  state->member_count = n;
+  state->group_members = group_members;
+  state->count = groups;
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  LOG("Aggregated %d windows into %d groups in %.3f ms", n, groups,
+      (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
 }
 
 /* --- Public API --- */
@@ -456,33 +1834,77 @@ int update_window_list(AppState *state, Config *cfg, bool is_linear) {
   if (!state)
     return -1;
 
+  /* Degraded path: no event stream, or a resync is still pending.  Show
+   * what we have rather than wait; the windows-changed callback reloads
+   * the panel once the resync lands. */
+  if (!model.synced) {
+    events_connect();
+    resync_model();
+  }
+
   /* Determine workspace filter target */
   int target_ws = WS_FILTER_NONE;
   if (state->filter_workspace) {
-    target_ws = get_active_workspace_id();
+    target_ws = model.active_ws;
     if (target_ws == WS_FILTER_NONE)
-      LOG("Workspace filter requested but query failed — showing all windows");
+      LOG("Workspace filter requested but active workspace unknown — showing "
+          "all windows");
+    else
+      LOG("Active workspace: %d", target_ws);
   }
 
-  char *json = hyprland_request("j/clients");
-  if (!json)
-    return -1;
-
-  if (parse_clients(json, state, target_ws) < 0) {
-    free(json);
-    return -1;
+  /* Size the snapshot's string arena in one go, ranking windows by
+   * recency on the way (Hyprland's focusHistoryID: 0 = most recent) */
+  size_t bytes = 0;
+  int rank = 0;
+  for (int i = model.mru_head; i >= 0; i = model.windows[i].mru_next) {
+    HyprWindow *w = &model.windows[i];
+    w->mru_rank = rank++;
+    bytes += strlen(w->title) + strlen(w->class_name) +
+             strlen(w->workspace_name) + 3;
   }
-  free(json);
+  if (app_state_reserve_strings(state, bytes) < 0)
+    return -1;
 
-  if (state->count > 1) {
+  /* Walk whichever index matches the requested order — no sorting */
+  int pos = 0;
+  int next = is_linear ? (model.live > 0 ? model.linear[0] : -1)
+                       : model.mru_head;
+  while (next >= 0) {
+    HyprWindow *w = &model.windows[next];
     if (is_linear) {
-      qsort(state->windows, state->count, sizeof(WindowInfo), compare_linear);
-      LOG("Sorted %d windows in linear order (workspace/address)", state->count);
+      pos++;
+      next = pos < model.live ? model.linear[pos] : -1;
     } else {
-      qsort(state->windows, state->count, sizeof(WindowInfo), compare_mru);
+      next = w->mru_next;
     }
+
+    /* Always skip special workspaces (id == -1) */
+    if (w->workspace_id == -1)
+      continue;
+
+    /* Workspace filter: skip windows not on the target workspace */
+    if (target_ws != WS_FILTER_NONE && w->workspace_id != target_ws)
+      continue;
+
+    WindowInfo info;
+    info.id = w->addr;
+    info.title = app_state_intern(state, w->title);
+    info.class_name = app_state_intern(state, w->class_name);
+    info.workspace_id = w->workspace_id;
+    info.workspace_name = app_state_intern(state, w->workspace_name);
+    info.focus_history_id = w->mru_rank;
+    info.is_active = (w->addr == model.active_addr);
+    info.is_floating = w->is_floating;
+    info.group_count = 1;
+    info.member_offset = -1;
+
+    app_state_add(state, &info);
   }
 
+  if (is_linear)
+    LOG("Listed %d windows in linear order (workspace/address)", state->count);
+
   if (cfg && cfg->mode == MODE_CONTEXT) {
     aggregate_context(state);
   }
@@ -490,31 +1912,63 @@ int update_window_list(AppState *state, Config *cfg, bool is_linear) {
   return 0;
 }
 
-void switch_to_window(const char *address) {
-  if (!address)
+/* --- Activation --- */
+
+/* When each activation in flight was asked for (tv_sec 0 = free); the
+ * reply callback gets its entry as `user` */
+static struct timespec activation_started[HYPRLAND_IPC_MAX_FDS];
+
+/* The reply (one "ok" per dispatch) only arrives once the whole batch has
+ * been processed, so this runs when the switch is acknowledged. */
+static void on_activation_reply(char *resp, size_t len, void *user) {
+  (void)len;
+  struct timespec *started = user;
+  struct timespec t0 = *started;
+  started->tv_sec = 0;
+  if (!resp) {
+    LOG("Activation request failed");
+    return;
+  }
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  LOG("Switch acknowledged in %.2f ms",
+      (now.tv_sec - t0.tv_sec) * 1e3 + (now.tv_nsec - t0.tv_nsec) / 1e6);
+
+  /* Anything besides "ok" replies and separators is an error message */
+  for (const char *p = resp; *p; p++) {
+    if (strncmp(p, "ok", 2) == 0) {
+      p++;
+    } else if (*p != '\n' && *p != ' ') {
+      LOG("Activation batch reported: %s", resp);
+      break;
+    }
+  }
+}
+
+void switch_to_window(uint64_t id, const struct timespec *started) {
+  if (!id)
     return;
 
-  char cmd1[256];
-  char cmd2[256];
+  /* The only place the address is needed as text */
+  char address[ADDRESS_STR_SIZE];
+  snprintf(address, sizeof(address), "0x%" PRIx64, id);
+
+  /* All dispatches go out as one [[BATCH]] request: Hyprland runs them in
+   * order within a single connection, so the focus change is committed
+   * before the Z-order change without any settle delay on our side. */
+  char cmd[512];
 
   if (use_lua_dispatch) {
-    /* 1. Target the specific window */
-    snprintf(cmd1, sizeof(cmd1), "dispatch hl.dsp.focus({ window = \"address:%s\" })", address);
-    /* 2. Pop it to the front if it's floating (ignored if tiled) */
-    snprintf(cmd2, sizeof(cmd2), "dispatch hl.dsp.window.alter_zorder({ mode = \"top\" })");
-
-    /* Fire both dispatches */
-    char *resp1 = hyprland_request(cmd1);
-    if (resp1) free(resp1);
-
-    char *resp2 = hyprland_request(cmd2);
-    if (resp2) free(resp2);
-
-    /* 3. Sledgehammer focus to break the layer-shell trap */
-    char cmd3[256];
-    snprintf(cmd3, sizeof(cmd3), "dispatch hl.dsp.focus({ window = \"activewindow\" })");
-    char *resp3 = hyprland_request(cmd3);
-    if (resp3) free(resp3);
+    /* 1. Target the specific window
+     * 2. Pop it to the front if it's floating (ignored if tiled)
+     * 3. Sledgehammer focus to break the layer-shell trap */
+    snprintf(cmd, sizeof(cmd),
+             "[[BATCH]]"
+             "dispatch hl.dsp.focus({ window = \"address:%s\" });"
+             "dispatch hl.dsp.window.alter_zorder({ mode = \"top\" });"
+             "dispatch hl.dsp.focus({ window = \"activewindow\" })",
+             address);
   } else {
     /* Legacy Fallback (hyprlang / pre-0.55)
      *
@@ -528,23 +1982,32 @@ void switch_to_window(const char *address) {
      * window, which undoes Step 1.  The layer-shell focus trap is already
      * broken by the explicit focuswindow dispatch since the panel surface
      * is destroyed before this function is called. */
-    snprintf(cmd1, sizeof(cmd1), "dispatch focuswindow address:%s", address);
-    snprintf(cmd2, sizeof(cmd2), "dispatch alterzorder top");
-
-    char *resp1 = hyprland_request(cmd1);
-    if (resp1) free(resp1);
+    snprintf(cmd, sizeof(cmd),
+             "[[BATCH]]dispatch focuswindow address:%s;dispatch alterzorder top",
+             address);
+  }
 
-    /* 5 ms settle time: Hyprland's synchronous IPC processes one
-     * connection at a time, but the compositor's internal focus-tree
-     * commit may not be fully visible to the next dispatch yet.
-     * This brief sleep lets the focus state propagate before we
-     * touch Z-order.  Imperceptible to users. */
-    {
-      struct timespec ts = {.tv_sec = 0, .tv_nsec = 5000000L};
-      nanosleep(&ts, NULL);
+  /* Every slot busy means every IPC connection is too: the request
+   * could not be submitted anyway, and a shared slot would be cleared
+   * under another activation */
+  struct timespec *t0 = NULL;
+  for (int i = 0; i < HYPRLAND_IPC_MAX_FDS; i++) {
+    if (activation_started[i].tv_sec == 0) {
+      t0 = &activation_started[i];
+      break;
     }
-
-    char *resp2 = hyprland_request(cmd2);
-    if (resp2) free(resp2);
+  }
+  if (!t0) {
+    LOG("Activation request dropped: %d activations in flight",
+        HYPRLAND_IPC_MAX_FDS);
+    return;
+  }
+  if (started)
+    *t0 = *started;
+  else
+    clock_gettime(CLOCK_MONOTONIC, t0);
+  if (ipc_submit(cmd, on_activation_reply, t0) < 0) {
+    LOG("Activation request failed");
+    t0->tv_sec = 0;
   }
 }
@@ -4,6 +4,11 @@
 
 #include "config.h"
 #include "data.h"
+#include <poll.h>
+#include <time.h>
+
+/* Upper bound on concurrent async IPC requests (and their poll fds) */
+#define HYPRLAND_IPC_MAX_FDS 4
 
 /* Initialize AppState */
 void app_state_init(AppState *state);
@@ -12,18 +17,38 @@ void app_state_init(AppState *state);
 void app_state_free(AppState *state);
 
 /*
- * Update window list from Hyprland.
+ * Update window list from Hyprland's event-driven window model (no IPC).
  * Populates state with windows, sorted by MRU (default) or
  * by workspace_id/address when is_linear is true.
  * Handles aggregation if Mode == CONTEXT.
  */
 int update_window_list(AppState *state, Config *config, bool is_linear);
 
-/* Switch focus to window address */
-void switch_to_window(const char *address);
+/* Switch focus to window `id` (its address; asynchronous, returns
+ * immediately).  The acknowledgement is logged with the time since
+ * `started` (NULL: since this call). */
+void switch_to_window(uint64_t id, const struct timespec *started);
 
 int hyprland_backend_init(void);
 void hyprland_backend_cleanup(void);
 const char *hyprland_get_name(void);
 
+/* Event stream fd for the daemon's poll loop (-1 if not connected) */
+int hyprland_get_event_fd(void);
+
+/* Drain pending events into the window model; resyncs on stream loss */
+void hyprland_dispatch_events(void);
+
+/* Fill `fds` with in-flight IPC requests; returns the number written */
+int hyprland_ipc_pollfds(struct pollfd *fds, int max);
+
+/* Advance IPC requests after poll() and expire overdue ones */
+void hyprland_ipc_dispatch(const struct pollfd *fds, int count);
+
+/* Called after an asynchronous resync has refreshed the window model */
+void hyprland_set_windows_changed_callback(void (*cb)(void));
+
+/* Called from the event stream when a window's title changes */
+void hyprland_set_title_changed_callback(void (*cb)(uint64_t id));
+
 #endif /* HYPRLAND_H */
\ No newline at end of file
@@ -5,11 +5,20 @@
 #include "icons.h"
 #include <ctype.h>
 #include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef HAVE_RSVG
@@ -17,14 +26,35 @@
 #endif
 
 #define LOG(fmt, ...) fprintf(stderr, "[Icons] " fmt "\n", ##__VA_ARGS__)
-#define MAX_CACHE 256
+
+/* Per-lookup tracing, too chatty for a warm start of hundreds of icons */
+#ifdef SNAPPY_DEBUG
+#define DEBUG_LOG(fmt, ...) LOG(fmt, ##__VA_ARGS__)
+#else
+#define DEBUG_LOG(fmt, ...)                                                    \
+  do {                                                                         \
+    if (0)                                                                     \
+      LOG(fmt, ##__VA_ARGS__);                                                 \
+  } while (0)
+#endif
 #define MAX_PATH 512
+#define NEGATIVE_TTL_MS 60000 /* How long a class is known to have no icon */
+#define LOADER_QUEUE_MAX 64
+#define ICON_SHOW_DEADLINE_MS 250 /* Later icons wait for the next show */
+#define REINDEX_DELAY_MS 500 /* Desktop entries quiet before re-indexing */
+
+#ifdef HAVE_RSVG
+#define SVG_SUPPORTED true
+#else
+#define SVG_SUPPORTED false
+#endif
 
 /* =========================================================================
  * CLASS NAME MAPPING TABLE
  * ========================================================================= */
 
-/* Maps WM_CLASS names that don't match their icon/desktop file names */
+/* Maps WM_CLASS names that don't match their icon/desktop file names.
+ * Consulted only when the desktop entry index has no match. */
 typedef struct {
   const char *wm_class;  /* WM_CLASS as reported by Wayland */
   const char *icon_name; /* Correct icon or desktop file name */
@@ -87,19 +117,25 @@ static const ClassMapping class_mappings[] = {
  * INTERNAL TYPES
  * ========================================================================= */
 
-/* Icon cache entry */
+/* Icon cache entry (see MEMORY CACHE) */
 typedef struct {
   char class_name[128];
-  int size;
-  cairo_surface_t *surface;
+  int size;                 /* Logical pixels */
+  int scale;
+  uint32_t hash;            /* cache_hash() of the key */
+  cairo_surface_t *surface; /* NULL: the class has no icon */
+  uint64_t expires_ms;      /* Misses only: when to look again */
+  size_t bytes;             /* Charged against the budget */
+  int prev, next;           /* LRU list; .next also links free entries */
 } IconCacheEntry;
 
 /* =========================================================================
  * GLOBAL STATE
  * ========================================================================= */
 
-static IconCacheEntry icon_cache[MAX_CACHE];
-static int cache_count = 0;
+/* The icon cache is filled by the loader thread and read by the render
+ * thread */
+static pthread_mutex_t cache_lock = PTHREAD_MUTEX_INITIALIZER;
 static char current_theme[64] = "Tela-dracula";
 static char fallback_theme_name[64] = "Tela-circle-dracula";
 
@@ -114,6 +150,9 @@ static char user_desktop_path[MAX_PATH];
 static char dyn_desktop_paths[64][MAX_PATH];
 static const char *desktop_dirs[64];
 
+/* Every stat() made, so lookups can show they make none */
+static unsigned long stat_calls = 0;
+
 /* =========================================================================
  * UTILITY FUNCTIONS
  * ========================================================================= */
@@ -130,6 +169,7 @@ static void to_lowercase(char *dest, const char *src, size_t max) {
 /* Check if file exists */
 static int file_exists(const char *path) {
   struct stat st;
+  stat_calls++;
   return stat(path, &st) == 0 && S_ISREG(st.st_mode);
 }
 
@@ -245,185 +285,777 @@ static void init_paths(void) {
 }
 
 /* =========================================================================
- * ICON THEME SEARCH
+ * ICON THEME INDEX
  * ========================================================================= */
 
-static char *find_icon_in_theme(const char *theme, const char *icon_name,
-                                int size) {
-  static char path[MAX_PATH];
-  (void)size; /* Size hint not used currently */
+/* Built by icons_init(): every theme in the lookup chain has its
+ * index.theme parsed and only the directories it lists are read.  Icon
+ * names map to their candidate files through an open-addressing hash
+ * table, so resolving a name never touches the filesystem.
+ *
+ * Installed apps ship their icons next to their desktop entries, so the
+ * loader rebuilds the index once desktop entries stop changing; lookups
+ * take index_lock against that. */
 
-  const char *sizes[] = {"scalable", "256x256", "128x128", "64x64", "48x48",
-                         "32x32",    "24x24",   "22x22",   "16x16"};
-  const char *categories[] = {"apps",   "applications", "mimetypes",
-                              "places", "devices",      "actions",
-                              "status", "categories"};
-  const char *extensions[] = {".svg", ".png", ".xpm"};
+#define MAX_THEMES 16
 
-  for (int d = 0; icon_dirs[d]; d++) {
-    if (!icon_dirs[d][0])
+enum { EXT_PNG, EXT_SVG };
+static const char *const index_exts[] = {".png", ".svg"};
+
+typedef enum { DIR_FIXED, DIR_SCALABLE, DIR_THRESHOLD } DirType;
+
+/* One [section] of an index.theme */
+typedef struct {
+  char *path; /* Relative to the theme, e.g. "48x48/apps" */
+  int theme;  /* Rank of the owning theme; lower wins */
+  int size, scale, min_size, max_size, threshold;
+  DirType type;
+} ThemeDir;
+
+typedef struct {
+  int next;     /* Next candidate for the same name, -1 ends the chain */
+  int dir;      /* ThemeDir index, -1 for pixmaps */
+  uint8_t base; /* icon_dirs[] index */
+  uint8_t ext;  /* EXT_* */
+} IconCandidate;
+
+typedef struct {
+  uint32_t hash; /* 0 = empty slot */
+  uint32_t name; /* Offset into icon_index.names */
+  int first;     /* Head of the candidate chain */
+} IndexSlot;
+
+static struct {
+  char themes[MAX_THEMES][64]; /* Lookup chain, in priority order */
+  int theme_count;
+  ThemeDir *dirs;
+  int dir_count, dir_cap;
+  IconCandidate *cands;
+  int cand_count, cand_cap;
+  IndexSlot *slots;
+  size_t slot_cap, slot_used;
+  char *names;
+  size_t names_len, names_cap;
+} icon_index;
+
+static pthread_mutex_t index_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t hash_name(const char *name, size_t len) {
+  uint32_t h = 2166136261u; /* FNV-1a */
+  for (size_t i = 0; i < len; i++)
+    h = (h ^ (unsigned char)name[i]) * 16777619u;
+  return h ? h : 1;
+}
+
+static IndexSlot *index_find(const char *name, size_t len) {
+  if (!icon_index.slot_cap)
+    return NULL;
+  uint32_t h = hash_name(name, len);
+  size_t mask = icon_index.slot_cap - 1;
+  for (size_t k = h & mask;; k = (k + 1) & mask) {
+    IndexSlot *s = &icon_index.slots[k];
+    if (s->hash == 0)
+      return NULL;
+    const char *n = icon_index.names + s->name;
+    if (s->hash == h && strncmp(n, name, len) == 0 && n[len] == '\0')
+      return s;
+  }
+}
+
+static bool index_grow(void) {
+  size_t cap = icon_index.slot_cap ? icon_index.slot_cap * 2 : 4096;
+  IndexSlot *slots = calloc(cap, sizeof(IndexSlot));
+  if (!slots)
+    return false;
+  for (size_t i = 0; i < icon_index.slot_cap; i++) {
+    IndexSlot *s = &icon_index.slots[i];
+    if (s->hash == 0)
       continue;
+    size_t k = s->hash & (cap - 1);
+    while (slots[k].hash)
+      k = (k + 1) & (cap - 1);
+    slots[k] = *s;
+  }
+  free(icon_index.slots);
+  icon_index.slots = slots;
+  icon_index.slot_cap = cap;
+  return true;
+}
 
-    /* Try theme/size/category/icon format */
-    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
-      for (size_t c = 0; c < sizeof(categories) / sizeof(categories[0]); c++) {
-        for (size_t e = 0; e < sizeof(extensions) / sizeof(extensions[0]);
-             e++) {
-          snprintf(path, sizeof(path), "%s/%s/%s/%s/%s%s", icon_dirs[d], theme,
-                   sizes[s], categories[c], icon_name, extensions[e]);
-          if (file_exists(path))
-            return path;
-        }
-      }
+/* Slot for `name`, created (with an empty chain) if missing */
+static IndexSlot *index_slot(const char *name, size_t len) {
+  IndexSlot *s = index_find(name, len);
+  if (s)
+    return s;
+
+  if ((icon_index.slot_used + 1) * 2 > icon_index.slot_cap && !index_grow())
+    return NULL;
+  if (icon_index.names_len + len + 1 > icon_index.names_cap) {
+    size_t cap = icon_index.names_cap ? icon_index.names_cap * 2 : 65536;
+    while (cap < icon_index.names_len + len + 1)
+      cap *= 2;
+    char *names = realloc(icon_index.names, cap);
+    if (!names)
+      return NULL;
+    icon_index.names = names;
+    icon_index.names_cap = cap;
+  }
+
+  uint32_t h = hash_name(name, len);
+  size_t mask = icon_index.slot_cap - 1;
+  size_t k = h & mask;
+  while (icon_index.slots[k].hash)
+    k = (k + 1) & mask;
+  s = &icon_index.slots[k];
+  s->hash = h;
+  s->name = (uint32_t)icon_index.names_len;
+  s->first = -1;
+  memcpy(icon_index.names + icon_index.names_len, name, len);
+  icon_index.names[icon_index.names_len + len] = '\0';
+  icon_index.names_len += len + 1;
+  icon_index.slot_used++;
+  return s;
+}
+
+static void index_add(const char *file, int dir, int base) {
+  size_t len = strlen(file);
+  int ext;
+  if (len > 4 && strcmp(file + len - 4, ".png") == 0)
+    ext = EXT_PNG;
+  else if (len > 4 && strcmp(file + len - 4, ".svg") == 0)
+    ext = EXT_SVG;
+  else
+    return; /* .xpm and friends: nothing can load them */
+
+  if (icon_index.cand_count == icon_index.cand_cap) {
+    int cap = icon_index.cand_cap ? icon_index.cand_cap * 2 : 8192;
+    IconCandidate *c = realloc(icon_index.cands, cap * sizeof(IconCandidate));
+    if (!c)
+      return;
+    icon_index.cands = c;
+    icon_index.cand_cap = cap;
+  }
+  IndexSlot *s = index_slot(file, len - 4);
+  if (!s)
+    return;
+
+  int i = icon_index.cand_count++;
+  icon_index.cands[i] = (IconCandidate){
+      .next = s->first, .dir = dir, .base = (uint8_t)base, .ext = (uint8_t)ext};
+  s->first = i;
+}
+
+static ThemeDir *theme_dir_new(const char *path, int theme) {
+  if (icon_index.dir_count == icon_index.dir_cap) {
+    int cap = icon_index.dir_cap ? icon_index.dir_cap * 2 : 64;
+    ThemeDir *d = realloc(icon_index.dirs, cap * sizeof(ThemeDir));
+    if (!d)
+      return NULL;
+    icon_index.dirs = d;
+    icon_index.dir_cap = cap;
+  }
+  char *copy = strdup(path);
+  if (!copy)
+    return NULL;
+  ThemeDir *d = &icon_index.dirs[icon_index.dir_count++];
+  *d = (ThemeDir){.path = copy, .theme = theme, .scale = 1,
+                  .threshold = 2, .type = DIR_THRESHOLD};
+  return d;
+}
+
+/* Whether comma-separated `list` contains `item` */
+static bool list_contains(const char *list, const char *item) {
+  size_t len = strlen(item);
+  for (const char *p = list; p; p = strchr(p, ',')) {
+    if (*p == ',')
+      p++;
+    if (strncmp(p, item, len) == 0 && (p[len] == ',' || p[len] == '\0'))
+      return true;
+  }
+  return false;
+}
+
+/* Parse an index.theme into ThemeDirs of rank `theme`; its Inherits= value
+ * is copied to `inherits` */
+static bool parse_index_theme(const char *file, int theme, char *inherits,
+                              size_t inherits_len) {
+  FILE *fp = fopen(file, "r");
+  if (!fp)
+    return false;
+
+  int first = icon_index.dir_count;
+  char listed[16384] = ""; /* Directories + ScaledDirectories */
+  ThemeDir *cur = NULL;
+  bool in_header = false;
+  char *line = NULL;
+  size_t cap = 0;
+
+  while (getline(&line, &cap, fp) > 0) {
+    size_t len = strlen(line);
+    while (len > 0 && isspace((unsigned char)line[len - 1]))
+      line[--len] = '\0';
+
+    if (line[0] == '[') {
+      char *end = strchr(line, ']');
+      cur = NULL;
+      in_header = false;
+      if (!end)
+        continue;
+      *end = '\0';
+      in_header = strcmp(line + 1, "Icon Theme") == 0;
+      if (!in_header)
+        cur = theme_dir_new(line + 1, theme);
+      continue;
     }
 
-    /* Try theme/category/size/icon format (alternate layout) */
-    for (size_t c = 0; c < sizeof(categories) / sizeof(categories[0]); c++) {
-      for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
-        for (size_t e = 0; e < sizeof(extensions) / sizeof(extensions[0]);
-             e++) {
-          snprintf(path, sizeof(path), "%s/%s/%s/%s/%s%s", icon_dirs[d], theme,
-                   categories[c], sizes[s], icon_name, extensions[e]);
-          if (file_exists(path))
-            return path;
-        }
+    char *eq = strchr(line, '=');
+    if (!eq)
+      continue;
+    *eq = '\0';
+    const char *key = line;
+    const char *val = eq + 1;
+
+    if (in_header) {
+      if (strcmp(key, "Directories") == 0 ||
+          strcmp(key, "ScaledDirectories") == 0) {
+        size_t used = strlen(listed);
+        snprintf(listed + used, sizeof(listed) - used, "%s%s",
+                 used ? "," : "", val);
+      } else if (strcmp(key, "Inherits") == 0) {
+        snprintf(inherits, inherits_len, "%s", val);
       }
+    } else if (cur) {
+      if (strcmp(key, "Size") == 0)
+        cur->size = atoi(val);
+      else if (strcmp(key, "Scale") == 0)
+        cur->scale = atoi(val);
+      else if (strcmp(key, "MinSize") == 0)
+        cur->min_size = atoi(val);
+      else if (strcmp(key, "MaxSize") == 0)
+        cur->max_size = atoi(val);
+      else if (strcmp(key, "Threshold") == 0)
+        cur->threshold = atoi(val);
+      else if (strcmp(key, "Type") == 0)
+        cur->type = strcmp(val, "Fixed") == 0      ? DIR_FIXED
+                    : strcmp(val, "Scalable") == 0 ? DIR_SCALABLE
+                                                   : DIR_THRESHOLD;
     }
   }
+  free(line);
+  fclose(fp);
 
-  /* Try pixmaps as last resort */
-  for (size_t e = 0; e < sizeof(extensions) / sizeof(extensions[0]); e++) {
-    snprintf(path, sizeof(path), "/usr/share/pixmaps/%s%s", icon_name,
-             extensions[e]);
-    if (file_exists(path))
-      return path;
+  /* Keep only the sections listed in the header */
+  int kept = first;
+  for (int i = first; i < icon_index.dir_count; i++) {
+    ThemeDir *d = &icon_index.dirs[i];
+    if (d->size <= 0 || !list_contains(listed, d->path)) {
+      free(d->path);
+      continue;
+    }
+    if (d->scale <= 0)
+      d->scale = 1;
+    if (d->min_size <= 0)
+      d->min_size = d->size;
+    if (d->max_size <= 0)
+      d->max_size = d->size;
+    icon_index.dirs[kept++] = *d;
   }
-
-  return NULL;
+  icon_index.dir_count = kept;
+  return true;
 }
 
-/* =========================================================================
- * DESKTOP FILE HANDLING
- * ========================================================================= */
-
-/* Scan directory for desktop file matching class name */
-static char *find_desktop_file_by_scan(const char *class_name) {
-  static char found_path[MAX_PATH];
-  char lowercase_class[128];
-  to_lowercase(lowercase_class, class_name, sizeof(lowercase_class));
+/* Append `name` and, depth-first, the themes it inherits to the chain */
+static void index_add_theme(const char *name) {
+  if (!name[0] || icon_index.theme_count >= MAX_THEMES)
+    return;
+  for (int t = 0; t < icon_index.theme_count; t++) {
+    if (strcmp(icon_index.themes[t], name) == 0)
+      return;
+  }
 
-  for (int d = 0; desktop_dirs[d]; d++) {
-    DIR *dir = opendir(desktop_dirs[d]);
-    if (!dir)
+  int rank = icon_index.theme_count;
+  char inherits[256] = "";
+  char file[MAX_PATH];
+  bool found = false;
+  for (int d = 0; icon_dirs[d] && !found; d++) {
+    if (!icon_dirs[d][0])
       continue;
+    snprintf(file, sizeof(file), "%s/%s/index.theme", icon_dirs[d], name);
+    found = parse_index_theme(file, rank, inherits, sizeof(inherits));
+  }
+  if (!found) {
+    LOG("Theme '%s' has no index.theme, skipping", name);
+    return;
+  }
 
-    struct dirent *entry;
-    while ((entry = readdir(dir)) != NULL) {
-      if (entry->d_type != DT_REG && entry->d_type != DT_LNK)
-        continue;
+  snprintf(icon_index.themes[rank], sizeof(icon_index.themes[rank]), "%s",
+           name);
+  icon_index.theme_count++;
+
+  char *saveptr = NULL;
+  for (char *tok = strtok_r(inherits, ",", &saveptr); tok;
+       tok = strtok_r(NULL, ",", &saveptr)) {
+    while (*tok == ' ')
+      tok++;
+    index_add_theme(tok);
+  }
+}
 
-      const char *name = entry->d_name;
-      size_t len = strlen(name);
-      if (len < 9 || strcmp(name + len - 8, ".desktop") != 0)
+/* Add every icon file in `path` as a candidate from ThemeDir `dir` */
+static void index_walk_dir(const char *path, int dir, int base) {
+  DIR *d = opendir(path);
+  if (!d)
+    return;
+  struct dirent *entry;
+  while ((entry = readdir(d)) != NULL) {
+    if (entry->d_type == DT_REG || entry->d_type == DT_LNK ||
+        entry->d_type == DT_UNKNOWN)
+      index_add(entry->d_name, dir, base);
+  }
+  closedir(d);
+}
+
+static void icon_index_free(void) {
+  for (int i = 0; i < icon_index.dir_count; i++)
+    free(icon_index.dirs[i].path);
+  free(icon_index.dirs);
+  free(icon_index.cands);
+  free(icon_index.slots);
+  free(icon_index.names);
+  memset(&icon_index, 0, sizeof(icon_index));
+}
+
+static void icon_index_build(void) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  icon_index_free();
+  index_add_theme(current_theme);
+  index_add_theme(fallback_theme_name);
+  index_add_theme("hicolor");
+  index_add_theme("Adwaita");
+
+  char path[MAX_PATH];
+  for (int i = 0; i < icon_index.dir_count; i++) {
+    const ThemeDir *td = &icon_index.dirs[i];
+    for (int d = 0; icon_dirs[d]; d++) {
+      if (!icon_dirs[d][0])
         continue;
+      snprintf(path, sizeof(path), "%s/%s/%s", icon_dirs[d],
+               icon_index.themes[td->theme], td->path);
+      index_walk_dir(path, i, d);
+    }
+  }
 
-      /* Convert filename to lowercase for comparison */
-      char lowercase_name[256];
-      to_lowercase(lowercase_name, name, sizeof(lowercase_name));
+  /* Unthemed legacy icons, below every theme */
+  for (int d = 0; icon_dirs[d]; d++) {
+    if (strcmp(icon_dirs[d], "/usr/share/pixmaps") == 0)
+      index_walk_dir(icon_dirs[d], -1, d);
+  }
 
-      /* Check various patterns:
-       * 1. classname.desktop
-       * 2. org.something.classname.desktop
-       * 3. com.company.classname.desktop
-       */
-      if (strstr(lowercase_name, lowercase_class) != NULL) {
-        snprintf(found_path, sizeof(found_path), "%s/%s", desktop_dirs[d],
-                 name);
-        closedir(dir);
-        LOG("Found desktop file: %s", found_path);
-        return found_path;
-      }
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  LOG("Indexed %zu icons (%d files, %d dirs, %d themes) in %.2f ms",
+      icon_index.slot_used, icon_index.cand_count, icon_index.dir_count,
+      icon_index.theme_count,
+      (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+}
+
+/* How far a directory's icons are from `size` pixels; 0 = usable as is */
+static int dir_distance(const ThemeDir *d, int size) {
+  int s = d->scale;
+  switch (d->type) {
+  case DIR_FIXED:
+    return abs(d->size * s - size);
+  case DIR_SCALABLE:
+    if (size < d->min_size * s)
+      return d->min_size * s - size;
+    if (size > d->max_size * s)
+      return size - d->max_size * s;
+    return 0;
+  case DIR_THRESHOLD:
+  default:
+    if (size < (d->size - d->threshold) * s)
+      return (d->size - d->threshold) * s - size;
+    if (size > (d->size + d->threshold) * s)
+      return size - (d->size + d->threshold) * s;
+    return 0;
+  }
+}
+
+/* Best file for `icon_name` at `size` pixels, written to `path`: the first
+ * theme in the chain that has it wins, then the closest size */
+static bool index_lookup(const char *icon_name, int size, bool allow_svg,
+                         char *path, size_t path_len) {
+  const IndexSlot *slot = index_find(icon_name, strlen(icon_name));
+  if (!slot)
+    return false;
+
+  const IconCandidate *best = NULL;
+  int best_rank = 0, best_dist = 0;
+  for (int i = slot->first; i >= 0; i = icon_index.cands[i].next) {
+    const IconCandidate *c = &icon_index.cands[i];
+    if (c->ext == EXT_SVG && !allow_svg)
+      continue;
+    int rank = icon_index.theme_count, dist = 0;
+    if (c->dir >= 0) {
+      rank = icon_index.dirs[c->dir].theme;
+      dist = dir_distance(&icon_index.dirs[c->dir], size);
+    }
+    if (!best || rank < best_rank ||
+        (rank == best_rank &&
+         (dist < best_dist || (dist == best_dist && c->base < best->base)))) {
+      best = c;
+      best_rank = rank;
+      best_dist = dist;
     }
-    closedir(dir);
   }
+  if (!best)
+    return false;
 
-  return NULL;
+  if (best->dir >= 0) {
+    const ThemeDir *td = &icon_index.dirs[best->dir];
+    snprintf(path, path_len, "%s/%s/%s/%s%s", icon_dirs[best->base],
+             icon_index.themes[td->theme], td->path, icon_name,
+             index_exts[best->ext]);
+  } else {
+    snprintf(path, path_len, "%s/%s%s", icon_dirs[best->base], icon_name,
+             index_exts[best->ext]);
+  }
+  return true;
 }
 
-/* Extract Icon= from desktop file */
-static char *extract_icon_from_desktop(const char *desktop_path) {
-  static char icon_name[256];
-  FILE *fp = fopen(desktop_path, "r");
+static bool icon_index_lookup(const char *icon_name, int size, bool allow_svg,
+                              char *path, size_t path_len) {
+  pthread_mutex_lock(&index_lock);
+  bool found = index_lookup(icon_name, size, allow_svg, path, path_len);
+  pthread_mutex_unlock(&index_lock);
+  return found;
+}
+
+/* =========================================================================
+ * DESKTOP ENTRY INDEX
+ * ========================================================================= */
+
+/* Every .desktop file in desktop_dirs is parsed once for Icon= and
+ * StartupWMClass=.  A class resolves through one hash probe on, in order
+ * of precedence, StartupWMClass, the file id ("org.gnome.Nautilus") or
+ * the id's last component ("nautilus"), all lowercase.  inotify keeps
+ * the index current: only the files that changed are parsed again.
+ *
+ * The loader thread applies the inotify events; load_app_icon() may also
+ * run elsewhere (has_app_icon), so lookups take desktop_lock. */
+
+enum { KEY_WM_CLASS, KEY_FILE_ID, KEY_ID_TAIL };
+
+typedef struct {
+  char *id;       /* Lowercase file id, without ".desktop" */
+  char *wm_class; /* Lowercase StartupWMClass, NULL if none */
+  char *icon;     /* Icon= value */
+  int dir;        /* desktop_dirs[] index; lower overrides higher */
+} DesktopEntry;
+
+typedef struct {
+  uint32_t hash;   /* 0 = empty slot */
+  int rank;        /* KEY_*; lower wins */
+  int entry;       /* Index into desktop.entries */
+  const char *key; /* Points into the entry's strings */
+} DesktopKey;
+
+static struct {
+  DesktopEntry *entries;
+  int count, cap;
+  DesktopKey *keys;
+  size_t key_cap;
+  int inotify_fd;
+  int wd[64]; /* Watch descriptor of each desktop_dirs[] entry */
+} desktop = {.inotify_fd = -1};
+
+static pthread_mutex_t desktop_lock = PTHREAD_MUTEX_INITIALIZER;
+/* Bumped whenever a class may resolve differently (see icons_generation) */
+static unsigned icon_generation = 0;
+/* Bumped when a requested icon lands (see icons_loaded_generation) */
+static unsigned loaded_generation = 0;
+
+static void desktop_entry_free(DesktopEntry *e) {
+  free(e->id);
+  free(e->wm_class);
+  free(e->icon);
+  memset(e, 0, sizeof(*e));
+}
+
+/* Parse the [Desktop Entry] group of desktop_dirs[dir]/name */
+static bool desktop_parse(int dir, const char *name, DesktopEntry *out) {
+  size_t len = strlen(name);
+  if (len < 9 || strcmp(name + len - 8, ".desktop") != 0)
+    return false;
+
+  char path[MAX_PATH];
+  snprintf(path, sizeof(path), "%s/%s", desktop_dirs[dir], name);
+  FILE *fp = fopen(path, "r");
   if (!fp)
-    return NULL;
+    return false;
 
+  char icon[256] = "", wm_class[128] = "";
+  bool in_entry = false;
   char line[512];
   while (fgets(line, sizeof(line), fp)) {
-    if (strncmp(line, "Icon=", 5) == 0) {
-      char *value = line + 5;
-      /* Remove newline and whitespace */
-      char *end = value + strlen(value) - 1;
-      while (end > value && (*end == '\n' || *end == '\r' || *end == ' ')) {
-        *end-- = '\0';
-      }
-      strncpy(icon_name, value, sizeof(icon_name) - 1);
-      icon_name[sizeof(icon_name) - 1] = '\0';
-      fclose(fp);
-      return icon_name;
+    size_t n = strlen(line);
+    while (n > 0 && isspace((unsigned char)line[n - 1]))
+      line[--n] = '\0';
+    if (line[0] == '[') {
+      if (in_entry)
+        break; /* Actions and other groups follow the main one */
+      in_entry = strcmp(line, "[Desktop Entry]") == 0;
+    } else if (in_entry && strncmp(line, "Icon=", 5) == 0) {
+      snprintf(icon, sizeof(icon), "%s", line + 5);
+    } else if (in_entry && strncmp(line, "StartupWMClass=", 15) == 0) {
+      to_lowercase(wm_class, line + 15, sizeof(wm_class));
     }
   }
   fclose(fp);
-  return NULL;
+  if (!icon[0])
+    return false;
+
+  char id[256];
+  to_lowercase(id, name, sizeof(id));
+  id[strlen(id) - 8] = '\0';
+
+  *out = (DesktopEntry){.id = strdup(id),
+                        .wm_class = wm_class[0] ? strdup(wm_class) : NULL,
+                        .icon = strdup(icon),
+                        .dir = dir};
+  if (!out->id || !out->icon || (wm_class[0] && !out->wm_class)) {
+    desktop_entry_free(out);
+    return false;
+  }
+  return true;
 }
 
-/* Find icon name from desktop file for a class name */
-static char *find_desktop_icon(const char *class_name) {
-  static char icon_name[256];
-  char desktop_path[MAX_PATH];
-  char lowercase[128];
-  to_lowercase(lowercase, class_name, sizeof(lowercase));
+static DesktopKey *desktop_probe(const char *key) {
+  if (!desktop.key_cap)
+    return NULL;
+  uint32_t h = hash_name(key, strlen(key));
+  size_t mask = desktop.key_cap - 1;
+  for (size_t k = h & mask;; k = (k + 1) & mask) {
+    DesktopKey *s = &desktop.keys[k];
+    if (s->hash == 0 || (s->hash == h && strcmp(s->key, key) == 0))
+      return s;
+  }
+}
 
-  /* Method 1: Try direct match lowercase.desktop */
+static void desktop_key_add(const char *key, int rank, int entry) {
+  DesktopKey *s = desktop_probe(key);
+  if (s->hash) {
+    const DesktopEntry *o = &desktop.entries[s->entry];
+    if (s->rank < rank ||
+        (s->rank == rank && o->dir <= desktop.entries[entry].dir))
+      return;
+  }
+  *s = (DesktopKey){.hash = hash_name(key, strlen(key)),
+                    .rank = rank,
+                    .entry = entry,
+                    .key = key};
+}
+
+/* Rebuild the key table from the entries (no I/O); desktop_lock held */
+static void desktop_rekey(void) {
+  size_t cap = 64;
+  while (cap < (size_t)desktop.count * 6)
+    cap *= 2;
+  if (cap != desktop.key_cap) {
+    DesktopKey *keys = realloc(desktop.keys, cap * sizeof(DesktopKey));
+    if (!keys) {
+      /* Entry indices moved: lookups fall back to class_mappings */
+      free(desktop.keys);
+      desktop.keys = NULL;
+      desktop.key_cap = 0;
+      return;
+    }
+    desktop.keys = keys;
+    desktop.key_cap = cap;
+  }
+  memset(desktop.keys, 0, desktop.key_cap * sizeof(DesktopKey));
+
+  for (int i = 0; i < desktop.count; i++) {
+    const DesktopEntry *e = &desktop.entries[i];
+    if (e->wm_class)
+      desktop_key_add(e->wm_class, KEY_WM_CLASS, i);
+    desktop_key_add(e->id, KEY_FILE_ID, i);
+    const char *tail = strrchr(e->id, '.');
+    if (tail && tail[1])
+      desktop_key_add(tail + 1, KEY_ID_TAIL, i);
+  }
+}
+
+static bool desktop_append(DesktopEntry *e) {
+  if (desktop.count == desktop.cap) {
+    int cap = desktop.cap ? desktop.cap * 2 : 256;
+    DesktopEntry *n = realloc(desktop.entries, cap * sizeof(DesktopEntry));
+    if (!n)
+      return false;
+    desktop.entries = n;
+    desktop.cap = cap;
+  }
+  desktop.entries[desktop.count++] = *e;
+  return true;
+}
+
+/* Re-read desktop_dirs[dir]/name after an inotify event */
+static void desktop_update(int dir, const char *name) {
+  DesktopEntry fresh;
+  bool parsed = desktop_parse(dir, name, &fresh);
+
+  char id[256];
+  to_lowercase(id, name, sizeof(id));
+  size_t len = strlen(id);
+  if (len > 8)
+    id[len - 8] = '\0';
+
+  pthread_mutex_lock(&desktop_lock);
+  for (int i = 0; i < desktop.count; i++) {
+    DesktopEntry *e = &desktop.entries[i];
+    if (e->dir == dir && strcmp(e->id, id) == 0) {
+      desktop_entry_free(e);
+      *e = desktop.entries[--desktop.count];
+      break;
+    }
+  }
+  if (parsed && !desktop_append(&fresh))
+    desktop_entry_free(&fresh);
+  desktop_rekey();
+  pthread_mutex_unlock(&desktop_lock);
+  LOG("Desktop entry %s: %s", parsed ? "updated" : "removed", name);
+}
+
+static void desktop_index_free(void) {
+  for (int i = 0; i < desktop.count; i++)
+    desktop_entry_free(&desktop.entries[i]);
+  free(desktop.entries);
+  free(desktop.keys);
+  desktop.entries = NULL;
+  desktop.keys = NULL;
+  desktop.count = desktop.cap = 0;
+  desktop.key_cap = 0;
+}
+
+static void desktop_index_build(void) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  pthread_mutex_lock(&desktop_lock);
+  desktop_index_free();
   for (int d = 0; desktop_dirs[d]; d++) {
-    snprintf(desktop_path, sizeof(desktop_path), "%s/%s.desktop",
-             desktop_dirs[d], lowercase);
-    if (file_exists(desktop_path)) {
-      char *icon = extract_icon_from_desktop(desktop_path);
-      if (icon)
-        return icon;
+    if (!desktop_dirs[d][0])
+      continue;
+    DIR *dir = opendir(desktop_dirs[d]);
+    if (!dir)
+      continue;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+      if (entry->d_type != DT_REG && entry->d_type != DT_LNK &&
+          entry->d_type != DT_UNKNOWN)
+        continue;
+      DesktopEntry e;
+      if (desktop_parse(d, entry->d_name, &e) && !desktop_append(&e))
+        desktop_entry_free(&e);
     }
+    closedir(dir);
   }
+  desktop_rekey();
+  pthread_mutex_unlock(&desktop_lock);
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  LOG("Indexed %d desktop entries in %.2f ms", desktop.count,
+      (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+}
+
+static void desktop_watch_start(void) {
+  if (desktop.inotify_fd < 0)
+    desktop.inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (desktop.inotify_fd < 0) {
+    LOG("inotify unavailable, desktop entries will not refresh");
+    return;
+  }
+  for (int d = 0; desktop_dirs[d]; d++) {
+    desktop.wd[d] = -1;
+    if (desktop_dirs[d][0])
+      desktop.wd[d] = inotify_add_watch(
+          desktop.inotify_fd, desktop_dirs[d],
+          IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+              IN_MOVED_TO | IN_ONLYDIR);
+  }
+}
+
+static void desktop_watch_stop(void) {
+  if (desktop.inotify_fd >= 0)
+    close(desktop.inotify_fd);
+  desktop.inotify_fd = -1;
+}
 
-  /* Method 2: Scan directories for matching desktop file */
-  char *found = find_desktop_file_by_scan(class_name);
-  if (found) {
-    char *icon = extract_icon_from_desktop(found);
-    if (icon)
-      return icon;
-  }
-
-  /* Method 3: Try common flatpak patterns */
-  const char *flatpak_patterns[] = {"org.gnome.%s",   "org.kde.%s",
-                                    "org.mozilla.%s", "com.github.%s",
-                                    "io.github.%s",   NULL};
-  for (int p = 0; flatpak_patterns[p]; p++) {
-    for (int d = 0; desktop_dirs[d]; d++) {
-      snprintf(desktop_path, sizeof(desktop_path), flatpak_patterns[p],
-               class_name);
-      char full_path[768]; /* Larger to avoid truncation */
-      snprintf(full_path, sizeof(full_path), "%s/%s.desktop", desktop_dirs[d],
-               desktop_path);
-      if (file_exists(full_path)) {
-        char *icon = extract_icon_from_desktop(full_path);
-        if (icon)
-          return icon;
+/* Apply pending inotify events; true if any entry changed */
+static bool desktop_dispatch(void) {
+  char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+  bool changed = false;
+  ssize_t n;
+  while ((n = read(desktop.inotify_fd, buf, sizeof(buf))) > 0) {
+    for (char *p = buf; p < buf + n;) {
+      const struct inotify_event *ev = (const struct inotify_event *)p;
+      p += sizeof(*ev) + ev->len;
+
+      if (ev->mask & IN_Q_OVERFLOW) {
+        LOG("inotify queue overflow, rebuilding desktop entry index");
+        desktop_index_build();
+        changed = true;
+        continue;
+      }
+      size_t len = ev->len ? strlen(ev->name) : 0;
+      if (len < 9 || strcmp(ev->name + len - 8, ".desktop") != 0)
+        continue;
+      for (int d = 0; desktop_dirs[d]; d++) {
+        if (desktop.wd[d] == ev->wd) {
+          desktop_update(d, ev->name);
+          changed = true;
+          break;
+        }
       }
     }
   }
+  return changed;
+}
+
+/* Icon name for `key` (a class) from the index, copied to `out` */
+static bool desktop_lookup(const char *key, char *out, size_t out_len) {
+  char lowercase[128];
+  to_lowercase(lowercase, key, sizeof(lowercase));
+
+  bool found = false;
+  pthread_mutex_lock(&desktop_lock);
+  DesktopKey *s = desktop_probe(lowercase);
+  if (s && s->hash) {
+    snprintf(out, out_len, "%s", desktop.entries[s->entry].icon);
+    found = true;
+  }
+  pthread_mutex_unlock(&desktop_lock);
+  return found;
+}
+
+/* Find icon name for a class name: the desktop index first, then the
+ * built-in class_mappings, then the lowercase class itself */
+static const char *find_desktop_icon(const char *class_name, char *out,
+                                     size_t out_len) {
+  if (desktop_lookup(class_name, out, out_len))
+    return out;
+
+  const char *mapped = get_mapped_class(class_name);
+  if (mapped) {
+    DEBUG_LOG("Mapped class '%s' -> '%s'", class_name, mapped);
+    if (!desktop_lookup(mapped, out, out_len))
+      snprintf(out, out_len, "%s", mapped);
+    return out;
+  }
 
-  /* Fallback: use lowercase class name as icon name */
-  strncpy(icon_name, lowercase, sizeof(icon_name) - 1);
-  return icon_name;
+  to_lowercase(out, class_name, out_len);
+  return out;
 }
 
 /* =========================================================================
@@ -467,51 +1099,17 @@ static cairo_surface_t *load_png_icon(const char *path, int size) {
   return surface;
 }
 
-/* Fallback: scan standard XDG paths for a PNG equivalent of an icon.
+/* Fallback: the best PNG for an icon in the theme index.
  * Used when an SVG path was resolved but HAVE_RSVG is not available,
  * or when the SVG render itself failed. */
 static cairo_surface_t *find_png_fallback(const char *icon_name, int size) {
-  char try_path[MAX_PATH];
-  /* Include user's active themes before falling back to hicolor/Adwaita */
-  const char *themes[] = {current_theme, fallback_theme_name, "hicolor", "Adwaita"};
-  const char *raster_sizes[] = {"256x256", "128x128", "64x64",
-                                "48x48",   "32x32",   "24x24"};
-  const char *categories[] = {"apps", "applications"};
-
-  for (size_t t = 0; t < sizeof(themes) / sizeof(themes[0]); t++) {
-    for (size_t rs = 0; rs < sizeof(raster_sizes) / sizeof(raster_sizes[0]);
-         rs++) {
-      for (int d = 0; icon_dirs[d]; d++) {
-        if (!icon_dirs[d][0])
-          continue;
-        for (size_t cat = 0; cat < sizeof(categories) / sizeof(categories[0]);
-             cat++) {
-          snprintf(try_path, sizeof(try_path), "%s/%s/%s/%s/%s.png",
-                   icon_dirs[d], themes[t], raster_sizes[rs], categories[cat],
-                   icon_name);
-          if (file_exists(try_path)) {
-            cairo_surface_t *s = load_png_icon(try_path, size);
-            if (s) {
-              LOG("PNG fallback loaded: %s", try_path);
-              return s;
-            }
-          }
-        }
-      }
-    }
-  }
-
-  /* Last resort: /usr/share/pixmaps */
-  snprintf(try_path, sizeof(try_path), "/usr/share/pixmaps/%s.png", icon_name);
-  if (file_exists(try_path)) {
-    cairo_surface_t *s = load_png_icon(try_path, size);
-    if (s) {
-      LOG("PNG fallback loaded (pixmaps): %s", try_path);
-      return s;
-    }
-  }
-
-  return NULL;
+  char path[MAX_PATH];
+  if (!icon_index_lookup(icon_name, size, false, path, sizeof(path)))
+    return NULL;
+  cairo_surface_t *s = load_png_icon(path, size);
+  if (s)
+    LOG("PNG fallback loaded: %s", path);
+  return s;
 }
 
 #ifdef HAVE_RSVG
@@ -611,168 +1209,929 @@ static cairo_surface_t *load_svg_icon(const char *path, int size) {
 }
 #endif
 
+/* Rasterize icon file `path` at `size`; `name` is the icon name searched
+ * for a PNG when an SVG cannot be rendered */
+static cairo_surface_t *load_icon_file(const char *path, const char *name,
+                                       int size) {
+  const char *ext = strrchr(path, '.');
+  if (ext && strcasecmp(ext, ".png") == 0)
+    return load_png_icon(path, size);
+  if (!ext || strcasecmp(ext, ".svg") != 0)
+    return NULL;
+
+  cairo_surface_t *surface = NULL;
+#ifdef HAVE_RSVG
+  surface = load_svg_icon(path, size);
+  if (!surface)
+    LOG("SVG load failed, trying PNG fallback for: %s", name);
+#else
+  LOG("SVG found but RSVG disabled, trying PNG fallback for: %s", name);
+#endif
+  if (!surface)
+    surface = find_png_fallback(name, size);
+  return surface;
+}
+
+/* The file a class's icon comes from (an absolute Icon= path or the best
+ * theme match), written to `path`; `name` receives the bare icon name */
+static bool resolve_icon_source(const char *class_name, int size, char *path,
+                                size_t path_len, char *name,
+                                size_t name_len) {
+  char icon_buf[256];
+  const char *icon_name =
+      find_desktop_icon(class_name, icon_buf, sizeof(icon_buf));
+  DEBUG_LOG("Class '%s' -> icon '%s'", class_name, icon_name);
+
+  if (icon_name[0] == '/') {
+    /* If the file is gone, its base name may still be in a theme */
+    const char *slash = strrchr(icon_name, '/');
+    snprintf(name, name_len, "%s", slash + 1);
+    char *dot = strrchr(name, '.');
+    if (dot)
+      *dot = '\0';
+    if (file_exists(icon_name)) {
+      snprintf(path, path_len, "%s", icon_name);
+      return true;
+    }
+  } else {
+    snprintf(name, name_len, "%s", icon_name);
+  }
+
+  /* Find icon file in themes (primary, fallback, hicolor, Adwaita) */
+  unsigned long stats_before = stat_calls;
+  bool found = icon_index_lookup(name, size, SVG_SUPPORTED, path, path_len);
+  DEBUG_LOG("Theme lookup '%s': %s (%lu stat calls)", name,
+            found ? path : "not found", stat_calls - stats_before);
+  return found;
+}
+
 /* =========================================================================
- * PUBLIC API
+ * MEMORY CACHE
  * ========================================================================= */
 
-/* Initialize icon system */
-void icons_init(const char *theme_name, const char *fallback) {
-  init_paths();
+/* Decoded icons keyed by (class, size, scale): an open-addressing table of
+ * indices into a pool of entries.  Entries sit on an LRU list, and the
+ * least recently used are evicted once the cache exceeds its byte budget
+ * ([icons] cache_size).  Misses are cached too, for NEGATIVE_TTL_MS, so an
+ * app without an icon is not searched for on every frame.  Everything here
+ * is called with cache_lock held. */
+
+static struct {
+  IconCacheEntry *entries; /* Pool */
+  int entry_cap;
+  int free_head;           /* Unused entries, chained through .next */
+  int *table;              /* Entry index per slot, -1 = empty */
+  size_t table_cap;
+  int lru_head, lru_tail;  /* Most and least recently used */
+  size_t budget;
+  IconCacheStats stats;
+} cache = {.free_head = -1, .lru_head = -1, .lru_tail = -1,
+           .budget = 32 << 20};
+
+static uint64_t now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
 
-  if (theme_name && theme_name[0]) {
-    strncpy(current_theme, theme_name, sizeof(current_theme) - 1);
-    current_theme[sizeof(current_theme) - 1] = '\0';
+static uint32_t cache_hash(const char *class_name, int size, int scale) {
+  uint32_t h = hash_name(class_name, strlen(class_name));
+  h ^= (uint32_t)(size * 31 + scale) * 2654435761u;
+  return h ? h : 1;
+}
+
+static void lru_unlink(int i) {
+  IconCacheEntry *e = &cache.entries[i];
+  if (e->prev >= 0)
+    cache.entries[e->prev].next = e->next;
+  else
+    cache.lru_head = e->next;
+  if (e->next >= 0)
+    cache.entries[e->next].prev = e->prev;
+  else
+    cache.lru_tail = e->prev;
+}
+
+static void lru_push(int i) {
+  IconCacheEntry *e = &cache.entries[i];
+  e->prev = -1;
+  e->next = cache.lru_head;
+  if (cache.lru_head >= 0)
+    cache.entries[cache.lru_head].prev = i;
+  cache.lru_head = i;
+  if (cache.lru_tail < 0)
+    cache.lru_tail = i;
+}
+
+/* Table slot holding the key, or the empty slot where it would go */
+static size_t cache_slot(const char *class_name, int size, int scale,
+                         uint32_t hash) {
+  size_t mask = cache.table_cap - 1;
+  for (size_t k = hash & mask;; k = (k + 1) & mask) {
+    int i = cache.table[k];
+    if (i < 0)
+      return k;
+    const IconCacheEntry *e = &cache.entries[i];
+    if (e->hash == hash && e->size == size && e->scale == scale &&
+        strcmp(e->class_name, class_name) == 0)
+      return k;
   }
-  if (fallback && fallback[0]) {
-    strncpy(fallback_theme_name, fallback, sizeof(fallback_theme_name) - 1);
-    fallback_theme_name[sizeof(fallback_theme_name) - 1] = '\0';
+}
+
+/* Empty `slot`, shifting later members of its probe run back so that
+ * lookups need no tombstones */
+static void table_delete(size_t slot) {
+  size_t mask = cache.table_cap - 1;
+  size_t hole = slot;
+  for (size_t k = (slot + 1) & mask; cache.table[k] >= 0; k = (k + 1) & mask) {
+    size_t home = cache.entries[cache.table[k]].hash & mask;
+    if (((k - home) & mask) >= ((k - hole) & mask)) {
+      cache.table[hole] = cache.table[k];
+      hole = k;
+    }
   }
+  cache.table[hole] = -1;
+}
 
-  cache_count = 0;
-  LOG("Initialized: theme=%s, fallback=%s", current_theme, fallback_theme_name);
+static void cache_remove(int i) {
+  IconCacheEntry *e = &cache.entries[i];
+  table_delete(cache_slot(e->class_name, e->size, e->scale, e->hash));
+  lru_unlink(i);
+  if (e->surface)
+    cairo_surface_destroy(e->surface);
+  e->surface = NULL;
+  cache.stats.bytes -= e->bytes;
+  cache.stats.entries--;
+  e->next = cache.free_head;
+  cache.free_head = i;
 }
 
-/* Load app icon by class name */
-cairo_surface_t *load_app_icon(const char *class_name, int size) {
-  if (!class_name || !class_name[0])
+static void icons_clear_cache(void) {
+  while (cache.lru_tail >= 0)
+    cache_remove(cache.lru_tail);
+}
+
+/* Double the pool and rebuild the table around the live entries */
+static bool cache_grow(void) {
+  int cap = cache.entry_cap ? cache.entry_cap * 2 : 64;
+  size_t table_cap = (size_t)cap * 2;
+  IconCacheEntry *entries =
+      realloc(cache.entries, cap * sizeof(IconCacheEntry));
+  if (!entries)
+    return false;
+  cache.entries = entries;
+  int *table = malloc(table_cap * sizeof(int));
+  if (!table)
+    return false;
+
+  for (int i = cap - 1; i >= cache.entry_cap; i--) {
+    entries[i].next = cache.free_head;
+    cache.free_head = i;
+  }
+  cache.entry_cap = cap;
+
+  free(cache.table);
+  cache.table = table;
+  cache.table_cap = table_cap;
+  memset(table, 0xff, table_cap * sizeof(int));
+  for (int i = cache.lru_head; i >= 0; i = entries[i].next) {
+    size_t k = entries[i].hash & (table_cap - 1);
+    while (table[k] >= 0)
+      k = (k + 1) & (table_cap - 1);
+    table[k] = i;
+  }
+  return true;
+}
+
+/* The live entry for the key, marked most recently used; expired misses
+ * are dropped */
+static IconCacheEntry *cache_find(const char *class_name, int size,
+                                  int scale) {
+  if (!cache.table_cap)
     return NULL;
+  size_t k = cache_slot(class_name, size, scale,
+                        cache_hash(class_name, size, scale));
+  int i = cache.table[k];
+  if (i < 0)
+    return NULL;
+  IconCacheEntry *e = &cache.entries[i];
+  if (!e->surface && now_ms() >= e->expires_ms) {
+    cache_remove(i);
+    cache.stats.expired++;
+    return NULL;
+  }
+  lru_unlink(i);
+  lru_push(i);
+  return e;
+}
 
-  /* Apply class name mapping first */
-  const char *effective_class = get_mapped_class(class_name);
-  if (effective_class) {
-    LOG("Mapped class '%s' -> '%s'", class_name, effective_class);
-  } else {
-    effective_class = class_name;
+/* Cache `surface` (NULL: known to have no icon), taking a reference, then
+ * evict down to the budget */
+static void cache_store(const char *class_name, int size, int scale,
+                        cairo_surface_t *surface) {
+  pthread_mutex_lock(&cache_lock);
+  IconCacheEntry *old = cache_find(class_name, size, scale);
+  if (old)
+    cache_remove((int)(old - cache.entries));
+  if (cache.free_head < 0 && !cache_grow()) {
+    pthread_mutex_unlock(&cache_lock);
+    return;
   }
 
-  /* Check cache using ORIGINAL class name (for consistency) */
-  for (int i = 0; i < cache_count; i++) {
-    if (strcmp(icon_cache[i].class_name, class_name) == 0 &&
-        icon_cache[i].size == size) {
-      if (icon_cache[i].surface) {
-        cairo_surface_reference(icon_cache[i].surface);
-      }
-      return icon_cache[i].surface;
-    }
+  int i = cache.free_head;
+  IconCacheEntry *e = &cache.entries[i];
+  cache.free_head = e->next;
+  snprintf(e->class_name, sizeof(e->class_name), "%s", class_name);
+  e->size = size;
+  e->scale = scale;
+  e->hash = cache_hash(class_name, size, scale);
+  e->surface = surface ? cairo_surface_reference(surface) : NULL;
+  e->expires_ms = surface ? 0 : now_ms() + NEGATIVE_TTL_MS;
+  e->bytes = sizeof(IconCacheEntry);
+  if (surface)
+    e->bytes += (size_t)cairo_image_surface_get_stride(surface) *
+                cairo_image_surface_get_height(surface);
+  cache.table[cache_slot(class_name, size, scale, e->hash)] = i;
+  lru_push(i);
+  cache.stats.bytes += e->bytes;
+  cache.stats.entries++;
+
+  while (cache.stats.bytes > cache.budget && cache.lru_tail != i) {
+    cache_remove(cache.lru_tail);
+    cache.stats.evictions++;
   }
+  pthread_mutex_unlock(&cache_lock);
+}
+
+/* =========================================================================
+ * DISK CACHE
+ * ========================================================================= */
 
-  /* Find icon name from desktop file using effective (mapped) class */
-  char *icon_name = find_desktop_icon(effective_class);
-  LOG("Class '%s' -> icon '%s'", effective_class,
-      icon_name ? icon_name : "(null)");
+/* Rasterized icons persist across restarts in
+ * $XDG_CACHE_HOME/snappy-switcher/icons.bin:
+ *
+ *   DiskHeader | DiskSlot[slots] (open addressing) | pixel data
+ *
+ * Pixels are cairo's native premultiplied ARGB32, stride size * 4.  The
+ * file is mmap'd at startup.  Every entry for the current themes is
+ * checked against its source file's mtime, and the valid ones are
+ * preloaded into the memory cache, so the first frame after a restart
+ * already has its icons.  Newly rasterized icons are written back with
+ * the stale entries left out once the loader goes idle. */
+
+#define DISK_MAGIC "SNAPICO"
+#define DISK_VERSION 1
+#define DISK_MAX_ENTRIES 512
+#define DISK_MAX_BYTES (16 << 20)
+#define DISK_MAX_SIZE 1024 /* Largest icon edge accepted from the file */
 
-  if (!icon_name) {
-    /* Cache NULL result */
-    if (cache_count < MAX_CACHE) {
-      strncpy(icon_cache[cache_count].class_name, class_name, 127);
-      icon_cache[cache_count].size = size;
-      icon_cache[cache_count].surface = NULL;
-      cache_count++;
-    }
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t slots; /* Power of two */
+  uint32_t count;
+  uint32_t reserved;
+} DiskHeader;
+
+typedef struct {
+  uint64_t key;                  /* disk_key(); 0 = empty slot */
+  uint64_t theme;                /* hash64() of the theme chain */
+  uint64_t source;               /* hash64() of the source file path */
+  int64_t mtime_sec, mtime_nsec; /* Of the source file */
+  uint64_t offset;               /* Of the pixels, from the file start */
+  uint32_t size;                 /* Edge in physical pixels */
+  char class_name[124];
+} DiskSlot;
+
+/* An icon rasterized this run, waiting to be written */
+typedef struct {
+  DiskSlot slot;
+  unsigned char *pixels;
+} DiskPending;
+
+static struct {
+  char path[MAX_PATH];
+  unsigned char *map; /* The file as opened (or last written) */
+  size_t map_size;
+  const DiskSlot *slots;
+  uint32_t slot_count;
+  bool *dropped;      /* Per slot: stale or superseded */
+  DiskPending *pending;
+  int pending_count, pending_cap;
+  bool dirty;
+  uint64_t theme;
+} disk;
+
+static uint64_t hash64(const char *str) {
+  uint64_t h = 14695981039346656037ull; /* FNV-1a */
+  for (const unsigned char *p = (const unsigned char *)str; *p; p++)
+    h = (h ^ *p) * 1099511628211ull;
+  return h;
+}
+
+static uint64_t disk_key(const char *class_name, int size, uint64_t theme) {
+  uint64_t h = hash64(class_name) ^ ((uint64_t)size * 0x9E3779B97F4A7C15ull);
+  h ^= theme + (h << 6) + (h >> 2);
+  return h ? h : 1;
+}
+
+static bool source_mtime(const char *path, struct timespec *mtime) {
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+  *mtime = st.st_mtim;
+  return true;
+}
+
+static void disk_unmap(void) {
+  if (disk.map)
+    munmap(disk.map, disk.map_size);
+  free(disk.dropped);
+  disk.map = NULL;
+  disk.map_size = 0;
+  disk.slots = NULL;
+  disk.slot_count = 0;
+  disk.dropped = NULL;
+}
+
+/* Map `disk.path` if it is a valid cache file of this version */
+static void disk_map(void) {
+  disk_unmap();
+  int fd = open(disk.path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DiskHeader)) {
+    close(fd);
+    return;
+  }
+  void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED)
+    return;
+
+  const DiskHeader *h = map;
+  size_t index_end = sizeof(DiskHeader) + (size_t)h->slots * sizeof(DiskSlot);
+  if (memcmp(h->magic, DISK_MAGIC, sizeof(h->magic)) != 0 ||
+      h->version != DISK_VERSION || h->slots == 0 ||
+      (h->slots & (h->slots - 1)) != 0 || h->slots > DISK_MAX_ENTRIES * 4 ||
+      index_end > (size_t)st.st_size) {
+    LOG("Disk cache %s is stale or corrupt, ignoring it", disk.path);
+    munmap(map, st.st_size);
+    return;
+  }
+
+  disk.map = map;
+  disk.map_size = st.st_size;
+  disk.slots = (const DiskSlot *)(disk.map + sizeof(DiskHeader));
+  disk.slot_count = h->slots;
+  disk.dropped = calloc(h->slots, sizeof(bool));
+  if (!disk.dropped)
+    disk_unmap();
+}
+
+/* Whether slot `i` holds an entry whose pixels lie inside the file */
+static bool disk_slot_valid(uint32_t i) {
+  const DiskSlot *d = &disk.slots[i];
+  return d->key && !disk.dropped[i] && d->size > 0 &&
+         d->size <= DISK_MAX_SIZE &&
+         memchr(d->class_name, '\0', sizeof(d->class_name)) &&
+         d->offset <= disk.map_size &&
+         (uint64_t)d->size * d->size * 4 <= disk.map_size - d->offset;
+}
+
+/* Copy slot `i`'s pixels into a new surface */
+static cairo_surface_t *disk_surface(uint32_t i) {
+  const DiskSlot *d = &disk.slots[i];
+  int size = (int)d->size;
+  cairo_surface_t *s =
+      cairo_image_surface_create(CAIRO_FORMAT_ARGB32, size, size);
+  if (cairo_surface_status(s) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(s);
     return NULL;
   }
+  cairo_surface_flush(s);
+  unsigned char *dst = cairo_image_surface_get_data(s);
+  int stride = cairo_image_surface_get_stride(s);
+  const unsigned char *src = disk.map + d->offset;
+  for (int y = 0; y < size; y++)
+    memcpy(dst + y * stride, src + (size_t)y * size * 4, (size_t)size * 4);
+  cairo_surface_mark_dirty(s);
+  return s;
+}
 
-  cairo_surface_t *surface = NULL;
+/* Open the cache file and preload every still-valid entry for the current
+ * themes into the memory cache (main thread, before the loader starts) */
+static void disk_cache_open(void) {
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
 
-  /* Check if icon_name is an absolute path */
-  if (icon_name[0] == '/' && file_exists(icon_name)) {
-    LOG("Loading absolute path icon: %s", icon_name);
-    const char *ext = strrchr(icon_name, '.');
-    if (ext) {
-      if (strcasecmp(ext, ".png") == 0) {
-        surface = load_png_icon(icon_name, size);
-      }
-#ifdef HAVE_RSVG
-      else if (strcasecmp(ext, ".svg") == 0) {
-        surface = load_svg_icon(icon_name, size);
-      }
-#endif
-#ifndef HAVE_RSVG
-      else if (strcasecmp(ext, ".svg") == 0) {
-        /* SVG found but no librsvg — extract base name and try PNG */
-        const char *slash = strrchr(icon_name, '/');
-        const char *base = slash ? slash + 1 : icon_name;
-        char base_name[256];
-        strncpy(base_name, base, sizeof(base_name) - 1);
-        base_name[sizeof(base_name) - 1] = '\0';
-        char *dot = strrchr(base_name, '.');
-        if (dot)
-          *dot = '\0';
-        LOG("SVG found but RSVG disabled, trying PNG fallback for: %s",
-            base_name);
-        surface = find_png_fallback(base_name, size);
-      }
-#endif
+  char themes[160];
+  snprintf(themes, sizeof(themes), "%s\n%s", current_theme,
+           fallback_theme_name);
+  disk.theme = hash64(themes);
+
+  const char *cache_home = getenv("XDG_CACHE_HOME");
+  const char *home = getenv("HOME");
+  char dir[MAX_PATH];
+  if (cache_home && cache_home[0])
+    snprintf(dir, sizeof(dir), "%s/snappy-switcher", cache_home);
+  else if (home)
+    snprintf(dir, sizeof(dir), "%s/.cache/snappy-switcher", home);
+  else
+    return;
+  snprintf(disk.path, sizeof(disk.path), "%s/icons.bin", dir);
+
+  /* The parent may not exist yet either */
+  char *slash = strrchr(dir, '/');
+  if (slash) {
+    *slash = '\0';
+    mkdir(dir, 0700);
+    *slash = '/';
+  }
+  if (mkdir(dir, 0700) != 0 && errno != EEXIST)
+    LOG("Cannot create %s: %s", dir, strerror(errno));
+
+  disk_map();
+  if (!disk.map)
+    return;
+
+  int loaded = 0, stale = 0;
+  for (uint32_t i = 0; i < disk.slot_count; i++) {
+    if (!disk_slot_valid(i) || disk.slots[i].theme != disk.theme)
+      continue; /* Kept for when those themes return */
+    const DiskSlot *d = &disk.slots[i];
+
+    char path[MAX_PATH], name[256];
+    struct timespec mtime;
+    if (!resolve_icon_source(d->class_name, (int)d->size, path, sizeof(path),
+                             name, sizeof(name)) ||
+        hash64(path) != d->source || !source_mtime(path, &mtime) ||
+        mtime.tv_sec != d->mtime_sec || mtime.tv_nsec != d->mtime_nsec) {
+      disk.dropped[i] = true;
+      disk.dirty = true;
+      stale++;
+      continue;
     }
-    if (surface) {
-      /* Cache result */
-      if (cache_count < MAX_CACHE) {
-        strncpy(icon_cache[cache_count].class_name, class_name, 127);
-        icon_cache[cache_count].size = size;
-        icon_cache[cache_count].surface = surface;
-        cairo_surface_reference(surface);
-        cache_count++;
-      }
-      return surface;
+
+    cairo_surface_t *s = disk_surface(i);
+    if (s) {
+      cache_store(d->class_name, (int)d->size, 1, s);
+      cairo_surface_destroy(s);
+      loaded++;
     }
-    /* SVG/PNG load failed - fall through to theme search */
-    LOG("Direct load failed, trying theme search for: %s", icon_name);
   }
 
-  /* Find icon file in themes */
-  char *icon_path = find_icon_in_theme(current_theme, icon_name, size);
-  if (!icon_path) {
-    icon_path = find_icon_in_theme(fallback_theme_name, icon_name, size);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  LOG("Preloaded %d icons from %s (%d stale) in %.2f ms", loaded, disk.path,
+      stale, (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6);
+}
+
+/* Queue a freshly rasterized icon for the next write */
+static void disk_cache_add(const char *class_name, int size, const char *path,
+                           cairo_surface_t *surface) {
+  struct timespec mtime;
+  if (!disk.path[0] || size > DISK_MAX_SIZE ||
+      cairo_image_surface_get_format(surface) != CAIRO_FORMAT_ARGB32 ||
+      cairo_image_surface_get_width(surface) != size ||
+      cairo_image_surface_get_height(surface) != size ||
+      !source_mtime(path, &mtime))
+    return;
+
+  if (disk.pending_count == disk.pending_cap) {
+    int cap = disk.pending_cap ? disk.pending_cap * 2 : 32;
+    DiskPending *n = realloc(disk.pending, cap * sizeof(DiskPending));
+    if (!n)
+      return;
+    disk.pending = n;
+    disk.pending_cap = cap;
   }
-  if (!icon_path) {
-    icon_path = find_icon_in_theme("hicolor", icon_name, size);
+  size_t row = (size_t)size * 4;
+  unsigned char *pixels = malloc(row * size);
+  if (!pixels)
+    return;
+  cairo_surface_flush(surface);
+  const unsigned char *src = cairo_image_surface_get_data(surface);
+  int stride = cairo_image_surface_get_stride(surface);
+  for (int y = 0; y < size; y++)
+    memcpy(pixels + y * row, src + y * stride, row);
+
+  DiskPending *p = &disk.pending[disk.pending_count++];
+  memset(p, 0, sizeof(*p));
+  p->slot.key = disk_key(class_name, size, disk.theme);
+  p->slot.theme = disk.theme;
+  p->slot.source = hash64(path);
+  p->slot.mtime_sec = mtime.tv_sec;
+  p->slot.mtime_nsec = mtime.tv_nsec;
+  p->slot.size = (uint32_t)size;
+  snprintf(p->slot.class_name, sizeof(p->slot.class_name), "%s", class_name);
+  p->pixels = pixels;
+  disk.dirty = true;
+}
+
+static bool write_all(int fd, const void *buf, size_t len) {
+  const unsigned char *p = buf;
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    p += n;
+    len -= n;
   }
-  if (!icon_path) {
-    icon_path = find_icon_in_theme("Adwaita", icon_name, size);
+  return true;
+}
+
+/* Whether an entry like `d` was rasterized again this run */
+static bool disk_superseded(const DiskSlot *d) {
+  for (int i = 0; i < disk.pending_count; i++) {
+    const DiskSlot *n = &disk.pending[i].slot;
+    if (n->key == d->key && n->theme == d->theme && n->size == d->size &&
+        strcmp(n->class_name, d->class_name) == 0)
+      return true;
   }
+  return false;
+}
 
-  surface = NULL;
+/* Write the new entries plus the old ones still valid, replacing the file
+ * atomically, then map the result */
+static void disk_cache_flush(void) {
+  if (!disk.dirty || !disk.path[0])
+    return;
+  disk.dirty = false;
+
+  /* Pick the entries: this run's first, then what the old file had */
+  int total = disk.pending_count + (int)disk.slot_count;
+  DiskSlot *out = calloc(total ? total : 1, sizeof(DiskSlot));
+  const unsigned char **src = calloc(total ? total : 1, sizeof(*src));
+  if (!out || !src) {
+    free(out);
+    free(src);
+    return;
+  }
+  int count = 0;
+  size_t bytes = 0;
+  for (int i = 0; i < disk.pending_count; i++) {
+    uint32_t size = disk.pending[i].slot.size;
+    size_t n = (size_t)size * size * 4;
+    if (count >= DISK_MAX_ENTRIES || bytes + n > DISK_MAX_BYTES)
+      break;
+    out[count] = disk.pending[i].slot;
+    src[count++] = disk.pending[i].pixels;
+    bytes += n;
+  }
+  for (uint32_t i = 0; i < disk.slot_count; i++) {
+    if (!disk_slot_valid(i) || disk_superseded(&disk.slots[i]))
+      continue;
+    size_t n = (size_t)disk.slots[i].size * disk.slots[i].size * 4;
+    if (count >= DISK_MAX_ENTRIES || bytes + n > DISK_MAX_BYTES)
+      break;
+    out[count] = disk.slots[i];
+    src[count++] = disk.map + disk.slots[i].offset;
+    bytes += n;
+  }
 
-  if (icon_path) {
-    LOG("Loading icon: %s", icon_path);
+  /* Lay out the index, then the pixels after it */
+  uint32_t slots = 16;
+  while (slots < (uint32_t)count * 2)
+    slots *= 2;
+  DiskSlot *index = calloc(slots, sizeof(DiskSlot));
+  const unsigned char **index_src = calloc(slots, sizeof(*index_src));
+  if (!index || !index_src) {
+    free(out);
+    free(src);
+    free(index);
+    free(index_src);
+    return;
+  }
+  uint64_t offset = sizeof(DiskHeader) + (uint64_t)slots * sizeof(DiskSlot);
+  for (int i = 0; i < count; i++) {
+    uint32_t k = (uint32_t)out[i].key & (slots - 1);
+    while (index[k].key)
+      k = (k + 1) & (slots - 1);
+    index[k] = out[i];
+    index[k].offset = offset;
+    index_src[k] = src[i];
+    offset += (uint64_t)out[i].size * out[i].size * 4;
+  }
 
-    const char *ext = strrchr(icon_path, '.');
-    if (ext) {
-      if (strcasecmp(ext, ".png") == 0) {
-        surface = load_png_icon(icon_path, size);
-      }
-#ifdef HAVE_RSVG
-      else if (strcasecmp(ext, ".svg") == 0) {
-        surface = load_svg_icon(icon_path, size);
-        /* If SVG render itself failed, try PNG fallback */
-        if (!surface) {
-          LOG("SVG load failed, trying PNG fallback for: %s", icon_name);
-          surface = find_png_fallback(icon_name, size);
-        }
-      }
-#endif
-#ifndef HAVE_RSVG
-      else if (strcasecmp(ext, ".svg") == 0) {
-        LOG("SVG found but RSVG disabled, searching PNG fallback for: %s",
-            icon_name);
-        surface = find_png_fallback(icon_name, size);
-      }
-#endif
+  char tmp[MAX_PATH + 8];
+  snprintf(tmp, sizeof(tmp), "%s.tmp", disk.path);
+  int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+  bool ok = fd >= 0;
+  DiskHeader header = {.version = DISK_VERSION,
+                       .slots = slots,
+                       .count = (uint32_t)count};
+  memcpy(header.magic, DISK_MAGIC, sizeof(header.magic));
+  ok = ok && write_all(fd, &header, sizeof(header)) &&
+       write_all(fd, index, slots * sizeof(DiskSlot));
+  for (uint32_t k = 0; ok && k < slots; k++) {
+    if (index[k].key)
+      ok = write_all(fd, index_src[k],
+                     (size_t)index[k].size * index[k].size * 4);
+  }
+  if (fd >= 0)
+    close(fd);
+  if (ok && rename(tmp, disk.path) == 0) {
+    LOG("Wrote %d icons (%zu KiB) to %s", count, bytes / 1024, disk.path);
+  } else {
+    LOG("Failed to write %s: %s", disk.path, strerror(errno));
+    unlink(tmp);
+  }
+
+  free(out);
+  free(src);
+  free(index);
+  free(index_src);
+  for (int i = 0; i < disk.pending_count; i++)
+    free(disk.pending[i].pixels);
+  disk.pending_count = 0;
+  disk_map();
+}
+
+static void disk_cache_close(void) {
+  disk_cache_flush();
+  disk_unmap();
+  free(disk.pending);
+  disk.pending = NULL;
+  disk.pending_cap = 0;
+  disk.path[0] = '\0';
+}
+
+/* =========================================================================
+ * BACKGROUND LOADER
+ * ========================================================================= */
+
+/* Icons are resolved and rasterized on a loader thread so a frame never
+ * waits for a desktop lookup, PNG decode or SVG render.  The render thread
+ * queues what it misses and draws the letter fallback; each icon that
+ * lands bumps loaded_generation and signals notify_fd, which the daemon
+ * loop polls to schedule a re-render.  Icons landing after the per-show
+ * deadline are kept for the next show instead, so a slow theme cannot
+ * keep the panel redrawing.  The loader also applies desktop entry
+ * changes, re-indexing the themes once they settle. */
+
+typedef struct {
+  char class_name[128];
+  int size;
+  int scale;
+} IconRequest;
+
+static struct {
+  pthread_t thread;
+  bool running;
+  bool quit;
+  int wake_fd;   /* eventfd: requests queued, or quit */
+  int notify_fd; /* eventfd: an icon landed or desktop entries changed */
+  pthread_mutex_t lock; /* Guards the fields below */
+  IconRequest queue[LOADER_QUEUE_MAX]; /* queue[0] is being loaded */
+  int count;
+  uint64_t deadline_ms; /* CLOCK_MONOTONIC; end of this show's updates */
+  bool late;            /* An icon landed past the deadline */
+} loader = {.wake_fd = -1, .notify_fd = -1,
+            .lock = PTHREAD_MUTEX_INITIALIZER};
+
+static void loader_signal(int fd) {
+  uint64_t one = 1;
+  if (write(fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    LOG("eventfd write failed: %s", strerror(errno));
+}
+
+/* Queue a load unless already queued; a full queue drops the request,
+ * which is made again by the next frame that misses the icon */
+static void loader_request(const char *class_name, int size, int scale) {
+  pthread_mutex_lock(&loader.lock);
+  for (int i = 0; i < loader.count; i++) {
+    if (loader.queue[i].size == size && loader.queue[i].scale == scale &&
+        strcmp(loader.queue[i].class_name, class_name) == 0) {
+      pthread_mutex_unlock(&loader.lock);
+      return;
     }
   }
+  if (loader.count < LOADER_QUEUE_MAX) {
+    IconRequest *r = &loader.queue[loader.count++];
+    snprintf(r->class_name, sizeof(r->class_name), "%s", class_name);
+    r->size = size;
+    r->scale = scale;
+  }
+  pthread_mutex_unlock(&loader.lock);
+  loader_signal(loader.wake_fd);
+}
+
+/* Retire queue[0] once its result is cached */
+static void loader_done(void) {
+  pthread_mutex_lock(&loader.lock);
+  memmove(&loader.queue[0], &loader.queue[1],
+          (loader.count - 1) * sizeof(IconRequest));
+  loader.count--;
+  bool on_time = now_ms() <= loader.deadline_ms;
+  if (!on_time)
+    loader.late = true;
+  pthread_mutex_unlock(&loader.lock);
+
+  if (on_time) {
+    __atomic_add_fetch(&loaded_generation, 1, __ATOMIC_RELEASE);
+    loader_signal(loader.notify_fd);
+  }
+}
+
+static void *loader_main(void *arg) {
+  (void)arg;
+  struct pollfd fds[2] = {{.fd = loader.wake_fd, .events = POLLIN},
+                          {.fd = desktop.inotify_fd, .events = POLLIN}};
+  uint64_t reindex_at = 0; /* Desktop entries changed: rebuild then */
+
+  while (!__atomic_load_n(&loader.quit, __ATOMIC_ACQUIRE)) {
+    IconRequest req;
+    pthread_mutex_lock(&loader.lock);
+    bool have = loader.count > 0;
+    if (have)
+      req = loader.queue[0];
+    pthread_mutex_unlock(&loader.lock);
+
+    if (have) {
+      struct timespec t0, t1;
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      cairo_surface_t *s = load_app_icon(req.class_name, req.size, req.scale);
+      if (s)
+        cairo_surface_destroy(s);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      DEBUG_LOG("Loaded '%s' in %.2f ms", req.class_name,
+                (t1.tv_sec - t0.tv_sec) * 1e3 +
+                    (t1.tv_nsec - t0.tv_nsec) / 1e6);
+      loader_done();
+      continue;
+    }
+
+    /* Idle: persist what this burst rasterized */
+    disk_cache_flush();
+
+    int timeout = -1;
+    if (reindex_at) {
+      uint64_t now = now_ms();
+      timeout = reindex_at > now ? (int)(reindex_at - now) : 0;
+    }
+    int ready = poll(fds, 2, timeout);
+    if (ready < 0 && errno != EINTR) {
+      LOG("Loader poll() failed: %s", strerror(errno));
+      break;
+    }
+    uint64_t count;
+    if (ready > 0 && (fds[0].revents & POLLIN) &&
+        read(loader.wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN)
+      LOG("eventfd read failed: %s", strerror(errno));
+    /* An install writes its icons around its desktop entry: wait for the
+     * burst to end, then pick both up together */
+    if (ready > 0 && (fds[1].revents & POLLIN) && desktop_dispatch())
+      reindex_at = now_ms() + REINDEX_DELAY_MS;
+
+    if (reindex_at && now_ms() >= reindex_at) {
+      reindex_at = 0;
+      pthread_mutex_lock(&index_lock);
+      icon_index_build();
+      pthread_mutex_unlock(&index_lock);
+      /* Clear before bumping: a tile redrawn for the new generation must
+       * not pick up an icon cached under the old entries */
+      pthread_mutex_lock(&cache_lock);
+      icons_clear_cache();
+      pthread_mutex_unlock(&cache_lock);
+      __atomic_add_fetch(&icon_generation, 1, __ATOMIC_RELEASE);
+      loader_signal(loader.notify_fd);
+    }
+  }
+  return NULL;
+}
+
+static void loader_start(void) {
+  loader.wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  loader.notify_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (loader.wake_fd < 0 || loader.notify_fd < 0) {
+    LOG("eventfd failed, icons load synchronously: %s", strerror(errno));
+    return;
+  }
+  loader.quit = false;
+  if (pthread_create(&loader.thread, NULL, loader_main, NULL) != 0) {
+    LOG("Failed to start icon loader, icons load synchronously");
+    return;
+  }
+  loader.running = true;
+}
+
+static void loader_stop(void) {
+  if (loader.running) {
+    __atomic_store_n(&loader.quit, true, __ATOMIC_RELEASE);
+    loader_signal(loader.wake_fd);
+    pthread_join(loader.thread, NULL);
+    loader.running = false;
+  }
+  loader.count = 0;
+  if (loader.wake_fd >= 0)
+    close(loader.wake_fd);
+  if (loader.notify_fd >= 0)
+    close(loader.notify_fd);
+  loader.wake_fd = loader.notify_fd = -1;
+}
+
+/* =========================================================================
+ * PUBLIC API
+ * ========================================================================= */
+
+/* Initialize icon system */
+void icons_init(const char *theme_name, const char *fallback,
+                size_t cache_bytes) {
+  init_paths();
+
+  if (theme_name && theme_name[0]) {
+    strncpy(current_theme, theme_name, sizeof(current_theme) - 1);
+    current_theme[sizeof(current_theme) - 1] = '\0';
+  }
+  if (fallback && fallback[0]) {
+    strncpy(fallback_theme_name, fallback, sizeof(fallback_theme_name) - 1);
+    fallback_theme_name[sizeof(fallback_theme_name) - 1] = '\0';
+  }
+
+  if (cache_bytes)
+    cache.budget = cache_bytes;
+  LOG("Initialized: theme=%s, fallback=%s, cache budget=%zu KiB",
+      current_theme, fallback_theme_name, cache.budget >> 10);
+  icon_index_build();
+  desktop_index_build();
+  desktop_watch_start();
+  disk_cache_open();
+  loader_start();
+}
+
+cairo_surface_t *icons_lookup(const char *class_name, int size, int scale,
+                              bool *pending) {
+  *pending = false;
+  if (!class_name || !class_name[0])
+    return NULL;
 
-  /* Cache result (including original class_name for cache lookup consistency)
-   */
-  if (cache_count < MAX_CACHE) {
-    strncpy(icon_cache[cache_count].class_name, class_name, 127);
-    icon_cache[cache_count].size = size;
-    icon_cache[cache_count].surface = surface;
-    if (surface) {
-      cairo_surface_reference(surface);
+  pthread_mutex_lock(&cache_lock);
+  IconCacheEntry *e = cache_find(class_name, size, scale);
+  if (e) {
+    cairo_surface_t *s = NULL;
+    if (e->surface) {
+      s = cairo_surface_reference(e->surface);
+      cache.stats.hits++;
+    } else {
+      cache.stats.negative_hits++;
     }
-    cache_count++;
+    pthread_mutex_unlock(&cache_lock);
+    return s;
   }
+  cache.stats.misses++;
+  pthread_mutex_unlock(&cache_lock);
+
+  if (!loader.running)
+    return load_app_icon(class_name, size, scale);
+  loader_request(class_name, size, scale);
+  *pending = true;
+  return NULL;
+}
+
+void icons_begin_show(void) {
+  pthread_mutex_lock(&loader.lock);
+  loader.deadline_ms = now_ms() + ICON_SHOW_DEADLINE_MS;
+  bool late = loader.late;
+  loader.late = false;
+  pthread_mutex_unlock(&loader.lock);
 
+  /* Placeholders waiting on icons that landed while hidden */
+  if (late)
+    __atomic_add_fetch(&loaded_generation, 1, __ATOMIC_RELEASE);
+}
+
+/* Load app icon by class name */
+cairo_surface_t *load_app_icon(const char *class_name, int size, int scale) {
+  if (!class_name || !class_name[0])
+    return NULL;
+  if (scale < 1)
+    scale = 1;
+
+  pthread_mutex_lock(&cache_lock);
+  IconCacheEntry *cached = cache_find(class_name, size, scale);
+  if (cached) {
+    cairo_surface_t *s = cached->surface
+                             ? cairo_surface_reference(cached->surface)
+                             : NULL;
+    pthread_mutex_unlock(&cache_lock);
+    return s;
+  }
+  pthread_mutex_unlock(&cache_lock);
+
+  char path[MAX_PATH], name[256];
+  cairo_surface_t *surface = NULL;
+  if (resolve_icon_source(class_name, size, path, sizeof(path), name,
+                          sizeof(name))) {
+    surface = load_icon_file(path, name, size);
+    if (surface)
+      disk_cache_add(class_name, size, path, surface);
+  }
+
+  /* Cache result, including a miss */
+  cache_store(class_name, size, scale, surface);
   return surface;
 }
 
@@ -781,13 +2140,7 @@ bool has_app_icon(const char *class_name) {
   if (!class_name)
     return false;
 
-  for (int i = 0; i < cache_count; i++) {
-    if (strcmp(icon_cache[i].class_name, class_name) == 0) {
-      return icon_cache[i].surface != NULL;
-    }
-  }
-
-  cairo_surface_t *s = load_app_icon(class_name, 48);
+  cairo_surface_t *s = load_app_icon(class_name, 48, 1);
   if (s) {
     cairo_surface_destroy(s);
     return true;
@@ -795,14 +2148,49 @@ bool has_app_icon(const char *class_name) {
   return false;
 }
 
+int icons_get_event_fd(void) { return loader.notify_fd; }
+
+bool icons_dispatch_events(void) {
+  uint64_t count = 0;
+  if (loader.notify_fd < 0 ||
+      read(loader.notify_fd, &count, sizeof(count)) < 0)
+    return false;
+  return count > 0;
+}
+
+unsigned icons_generation(void) {
+  return __atomic_load_n(&icon_generation, __ATOMIC_ACQUIRE);
+}
+
+unsigned icons_loaded_generation(void) {
+  return __atomic_load_n(&loaded_generation, __ATOMIC_ACQUIRE);
+}
+
+void icons_get_stats(IconCacheStats *out) {
+  pthread_mutex_lock(&cache_lock);
+  *out = cache.stats;
+  out->budget = cache.budget;
+  pthread_mutex_unlock(&cache_lock);
+}
+
 /* Cleanup all cached icons */
 void icons_cleanup(void) {
-  for (int i = 0; i < cache_count; i++) {
-    if (icon_cache[i].surface) {
-      cairo_surface_destroy(icon_cache[i].surface);
-      icon_cache[i].surface = NULL;
-    }
-  }
-  cache_count = 0;
+  loader_stop();
+  disk_cache_close();
+  pthread_mutex_lock(&cache_lock);
+  icons_clear_cache();
+  free(cache.entries);
+  free(cache.table);
+  cache.entries = NULL;
+  cache.table = NULL;
+  cache.entry_cap = 0;
+  cache.table_cap = 0;
+  cache.free_head = -1;
+  pthread_mutex_unlock(&cache_lock);
+  icon_index_free();
+  desktop_watch_stop();
+  pthread_mutex_lock(&desktop_lock);
+  desktop_index_free();
+  pthread_mutex_unlock(&desktop_lock);
   LOG("Cache cleared");
 }
@@ -4,12 +4,40 @@
 
 #include <cairo/cairo.h>
 #include <stdbool.h>
+#include <stddef.h>
 
-/* Initialize icon cache and theme lookup */
-void icons_init(const char *theme_name, const char *fallback_theme);
+/* Memory cache counters; hits and misses count icons_lookup() calls */
+typedef struct {
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long negative_hits; /* Classes known to have no icon */
+  unsigned long evictions;     /* Dropped to stay within the budget */
+  unsigned long expired;       /* Cached misses looked up again */
+  int entries;
+  size_t bytes;
+  size_t budget;
+} IconCacheStats;
 
-/* Load an app icon by class name (returns NULL if not found) */
-cairo_surface_t *load_app_icon(const char *class_name, int size);
+/* Initialize icon cache and theme lookup; cache_bytes bounds the memory
+ * cache (0 = default) */
+void icons_init(const char *theme_name, const char *fallback_theme,
+                size_t cache_bytes);
+
+/* Load an app icon by class name (returns NULL if not found), cached per
+ * output scale.
+ * Blocks on disk and decoding; frames use icons_lookup() instead. */
+cairo_surface_t *load_app_icon(const char *class_name, int size, int scale);
+
+/* The icon for `class_name` without blocking: a new reference if loaded,
+ * NULL if it has none or is still loading.  In the latter case *pending is
+ * set and a load is queued; when it lands icons_loaded_generation()
+ * changes and the event fd fires. */
+cairo_surface_t *icons_lookup(const char *class_name, int size, int scale,
+                              bool *pending);
+
+/* Start of a show: icons landing later than a short deadline after this
+ * no longer trigger redraws (they are picked up by the next show) */
+void icons_begin_show(void);
 
 /* Free all cached icons */
 void icons_cleanup(void);
@@ -17,4 +45,19 @@ void icons_cleanup(void);
 /* Check if icon exists for app */
 bool has_app_icon(const char *class_name);
 
+/* Fires when an icon lands or desktop entries change (-1 if unavailable) */
+int icons_get_event_fd(void);
+
+/* Drain the event fd; true if the panel should be redrawn */
+bool icons_dispatch_events(void);
+
+/* Changes whenever icons loaded earlier (or drawn with them) may be stale */
+unsigned icons_generation(void);
+
+/* Changes whenever a queued icon lands (placeholders may be replaced) */
+unsigned icons_loaded_generation(void);
+
+/* Snapshot of the memory cache counters */
+void icons_get_stats(IconCacheStats *out);
+
 #endif /* ICONS_H */
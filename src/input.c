@@ -267,7 +267,7 @@ static void keyboard_enter(void *data, struct wl_keyboard *keyboard,
         app_state->error_message =
             strdup("CONFIG ERROR: Dismiss key not held.\n"
                    "Ensure --mod flag matches your keybind.");
-        app_state->needs_render = true;
+        app_state->needs_render++;
         LOG("ERROR: Dismiss key not held (depressed=0x%x) — switcher disarmed",
             mods_depressed);
       } else if (keys->size == 0) {
@@ -337,7 +337,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
         if (app_state->selected_index >= app_state->count)
           app_state->selected_index = 0;
       }
-      app_state->needs_render = true;
+      app_state->needs_render++;
     }
     break;
 
@@ -346,7 +346,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
       app_state->selected_index--;
       if (app_state->selected_index < 0)
         app_state->selected_index = app_state->count - 1;
-      app_state->needs_render = true;
+      app_state->needs_render++;
     }
     break;
 
@@ -355,7 +355,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
       app_state->selected_index++;
       if (app_state->selected_index >= app_state->count)
         app_state->selected_index = 0;
-      app_state->needs_render = true;
+      app_state->needs_render++;
     }
     break;
 
@@ -364,7 +364,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
       int next = app_state->selected_index - app_state->cols;
       if (next >= 0)
         app_state->selected_index = next;
-      app_state->needs_render = true;
+      app_state->needs_render++;
     }
     break;
 
@@ -373,7 +373,7 @@ static void keyboard_key(void *data, struct wl_keyboard *keyboard,
       int next = app_state->selected_index + app_state->cols;
       if (next < app_state->count)
         app_state->selected_index = next;
-      app_state->needs_render = true;
+      app_state->needs_render++;
     }
     break;
 
@@ -470,7 +470,7 @@ static void keyboard_modifiers(void *data, struct wl_keyboard *keyboard,
           app_state->error_message =
               strdup("CONFIG ERROR: Modifier not held.\n"
                      "Ensure --mod flag matches your keybind.");
-          app_state->needs_render = true;
+          app_state->needs_render++;
           LOG("ERROR: Dismiss modifier not held (depressed=0x%x) — switcher "
               "disarmed", depressed);
         } else {
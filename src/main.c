@@ -3,6 +3,7 @@
 
 #include "backend.h"
 #include "config.h"
+#include "hyprland.h"
 #include "icons.h"
 #include "input.h"
 #include "render.h"
@@ -89,7 +90,7 @@ static void layer_surface_configure(void *data,
   is_configured = true;
 
   if (visible) {
-    app_state.needs_render = true;
+    app_state.needs_render++;
   }
 }
 
@@ -222,6 +223,7 @@ static void destroy_panel(void) {
   }
   visible = false;
   is_configured = false;
+  render_forget_surface();
   LOG("Panel destroyed");
 }
 
@@ -277,6 +279,12 @@ static void hide_switcher(void) {
   /* Reset workspace filter so it doesn't leak into the next session */
   app_state.filter_workspace = false;
 
+  /* Cards of windows that were not shown this session are not worth keeping */
+  render_trim_cache();
+  render_reset_pacing(); /* A hidden surface may never get its callback */
+  app_state.needs_render = 0;
+  render_log_stats();
+
   if (config && config->follow_monitor) {
     destroy_panel();
   } else {
@@ -287,6 +295,32 @@ static void hide_switcher(void) {
   }
 }
 
+/* Sort order of the currently shown list, for reload_windows() */
+static bool shown_linear = false;
+
+/* The selection a freshly shown list starts with */
+static int initial_selection(bool is_linear) {
+  if (is_linear) {
+    /* Linear mode: find where the active window landed in the
+     * deterministic sort order and select relative to it. */
+    int active_idx = 0;
+    for (int i = 0; i < app_state.count; i++) {
+      if (app_state.windows[i].is_active) {
+        active_idx = i;
+        break;
+      }
+    }
+    if (config && config->sticky_mode)
+      return active_idx;
+    return (app_state.count > 1) ? (active_idx + 1) % app_state.count : 0;
+  }
+
+  /* MRU mode: active window is always index 0 */
+  if (config && config->sticky_mode)
+    return 0;
+  return (app_state.count > 1) ? 1 : 0;
+}
+
 static void show_switcher(bool is_linear) {
   LOG("Showing switcher...");
 
@@ -301,6 +335,7 @@ static void show_switcher(bool is_linear) {
   }
 
   input_reset_alt_state();
+  icons_begin_show();
 
   /* Preserve filter_workspace across state reset — it was set by
    * handle_command() before we were called, and app_state_init()
@@ -321,32 +356,8 @@ static void show_switcher(bool is_linear) {
     LOG("Failed to update window list");
     return;
   }
-
-  if (is_linear) {
-    /* Linear mode: find where the active window landed in the
-     * deterministic sort order and select relative to it. */
-    int active_idx = 0;
-    for (int i = 0; i < app_state.count; i++) {
-      if (app_state.windows[i].is_active) {
-        active_idx = i;
-        break;
-      }
-    }
-    if (config && config->sticky_mode) {
-      app_state.selected_index = active_idx;
-    } else {
-      app_state.selected_index = (app_state.count > 1)
-          ? (active_idx + 1) % app_state.count
-          : 0;
-    }
-  } else {
-    /* MRU mode: active window is always index 0 */
-    if (config && config->sticky_mode) {
-      app_state.selected_index = 0;
-    } else {
-      app_state.selected_index = (app_state.count > 1) ? 1 : 0;
-    }
-  }
+  shown_linear = is_linear;
+  app_state.selected_index = initial_selection(is_linear);
 
   calculate_dimensions(&app_state, &app_state.width, &app_state.height);
   int max_cols = config ? config->max_cols : 5;
@@ -362,21 +373,108 @@ static void show_switcher(bool is_linear) {
   wl_display_flush(display);
 }
 
+/* The backend refreshed its window list (a Hyprland resync landed) while
+ * the panel is open: reload it, keeping the selected window selected. */
+static void reload_windows(void) {
+  if (!visible || !backend)
+    return;
+
+  int selected = app_state.selected_index;
+  bool had_windows = app_state.count > 0;
+  uint64_t selected_id = 0;
+  if (selected >= 0 && selected < app_state.count)
+    selected_id = app_state.windows[selected].id;
+  uint32_t old_w = app_state.width, old_h = app_state.height;
+  bool ws_filter = app_state.filter_workspace;
+  char *error = app_state.error_message;
+  app_state.error_message = NULL;
+
+  app_state_free(&app_state);
+  app_state_init(&app_state);
+  app_state.filter_workspace = ws_filter;
+  app_state.error_message = error;
+
+  if (backend->get_windows(&app_state, config, shown_linear) < 0) {
+    LOG("Failed to reload window list");
+    return;
+  }
+  LOG("Reloaded window list (%d windows)", app_state.count);
+
+  if (!had_windows) {
+    /* Nothing was selectable: start as if the panel had just been shown */
+    selected = initial_selection(shown_linear);
+  } else {
+    /* The selected window may have moved; if it is gone, keep the slot */
+    for (int i = 0; i < app_state.count; i++) {
+      if (app_state.windows[i].id == selected_id) {
+        selected = i;
+        break;
+      }
+    }
+    if (selected >= app_state.count)
+      selected = app_state.count > 0 ? app_state.count - 1 : 0;
+  }
+  app_state.selected_index = selected;
+
+  calculate_dimensions(&app_state, &app_state.width, &app_state.height);
+  int max_cols = config ? config->max_cols : 5;
+  app_state.cols = (app_state.count < max_cols) ? app_state.count : max_cols;
+  if (app_state.width != old_w || app_state.height != old_h) {
+    /* The configure event that follows triggers the render */
+    zwlr_layer_surface_v1_set_size(layer_surface, app_state.width,
+                                   app_state.height);
+    wl_surface_commit(surface);
+  } else {
+    app_state.needs_render++;
+  }
+}
+
 static void select_and_hide(void) {
-  char *address = NULL;
+  uint64_t id = 0;
+  bool have_target = false;
   if (visible && app_state.count > 0 && backend) {
     WindowInfo *win = &app_state.windows[app_state.selected_index];
-    address = strdup(win->address);
+    id = win->id;
+    have_target = true;
     LOG("Switching to: %s (using %s backend)", win->title, backend->get_name());
   }
+  /* The backend logs the end-to-end latency from here */
+  struct timespec t0;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
   hide_switcher();
-  if (address) {
-    backend->activate_window(address);
-    free(address);
+  if (have_target)
+    backend->activate_window(id, &t0);
+}
+
+/* Reply to STATS with the icon cache counters, one "key value" per line */
+static void send_stats(int client) {
+  IconCacheStats st;
+  icons_get_stats(&st);
+  char reply[512];
+  int len = snprintf(reply, sizeof(reply),
+                     "icon_cache_entries %d\n"
+                     "icon_cache_bytes %zu\n"
+                     "icon_cache_budget %zu\n"
+                     "icon_cache_hits %lu\n"
+                     "icon_cache_misses %lu\n"
+                     "icon_cache_negative_hits %lu\n"
+                     "icon_cache_evictions %lu\n"
+                     "icon_cache_expired %lu\n",
+                     st.entries, st.bytes, st.budget, st.hits, st.misses,
+                     st.negative_hits, st.evictions, st.expired);
+  for (int off = 0; off < len;) {
+    ssize_t n = write(client, reply + off, len - off);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      LOG("Failed to send stats: %s", strerror(errno));
+      return;
+    }
+    off += n;
   }
 }
 
-static void handle_command(const char *payload) {
+static void handle_command(const char *payload, int client) {
   /* Protocol: CMD:MOD:WORKSPACE_FLAG:SOURCE:SILENT_FLAG:LINEAR_FLAG
    * Also supports legacy bare commands (e.g. "QUIT" from takeover)
    * and 4/5-field payloads (SILENT_FLAG/LINEAR_FLAG default to "0"). */
@@ -425,6 +523,10 @@ static void handle_command(const char *payload) {
     should_quit = 1;
     return;
   }
+  if (strcmp(cmd_buf, CMD_STATS) == 0) {
+    send_stats(client);
+    return;
+  }
   if (strcmp(cmd_buf, CMD_HIDE) == 0) {
     hide_switcher();
     return;
@@ -488,16 +590,13 @@ static void handle_command(const char *payload) {
       target = (dir == 1) ? 1 : silent_state.count - 1;
     }
 
-    char *address = strdup(silent_state.windows[target].address);
+    uint64_t id = silent_state.windows[target].id;
     LOG("Silent mode: focusing window '%s' (index %d/%d)",
         silent_state.windows[target].title, target, silent_state.count);
 
     app_state_free(&silent_state);
 
-    if (address) {
-      backend->activate_window(address);
-      free(address);
-    }
+    backend->activate_window(id, NULL);
     return; /* CRITICAL: do NOT fall through to the GUI path */
   }
 
@@ -543,7 +642,7 @@ static void handle_command(const char *payload) {
         app_state.selected_index =
             (app_state.selected_index + dir + app_state.count) %
             app_state.count;
-        app_state.needs_render = true;
+        app_state.needs_render++;
       }
     }
     return;
@@ -609,6 +708,8 @@ static int run_client(int argc, char **argv) {
     proto_cmd = CMD_HIDE;
   else if (strcmp(cmd, "quit") == 0)
     proto_cmd = CMD_QUIT;
+  else if (strcmp(cmd, "stats") == 0)
+    proto_cmd = CMD_STATS;
   else {
     fprintf(stderr, "%s: unknown command '%s'\n", prog, cmd);
     return 1;
@@ -625,6 +726,13 @@ static int run_client(int argc, char **argv) {
             "Daemon not running. Start with: snappy-switcher --daemon\n");
     return 1;
   }
+  if (strcmp(proto_cmd, CMD_STATS) == 0) {
+    char reply[1024];
+    if (send_command_reply(payload, reply, sizeof(reply)) != 0)
+      return 1;
+    fputs(reply, stdout);
+    return 0;
+  }
   return send_command(payload) == 0 ? 0 : 1;
 }
 
@@ -697,7 +805,9 @@ static int run_daemon(const char *config_path) {
   if (!config)
     config = get_default_config();
   render_set_config(config);
-  icons_init(config->icon_theme, config->icon_fallback);
+  icons_init(config->icon_theme, config->icon_fallback,
+             config->icon_cache_mb > 0 ? (size_t)config->icon_cache_mb << 20
+                                       : 0);
   /* dismiss_modifier is now set dynamically per-command via IPC */
   app_state_init(&app_state);
 
@@ -707,6 +817,8 @@ static int run_daemon(const char *config_path) {
     return 1;
   }
   LOG("Using %s backend", backend->get_name());
+  hyprland_set_windows_changed_callback(reload_windows);
+  hyprland_set_title_changed_callback(render_invalidate_title);
 
   /* Callbacks */
   on_alt_release = select_and_hide;
@@ -772,17 +884,29 @@ static int run_daemon(const char *config_path) {
 
   LOG("Daemon Started (PID: %d)", getpid());
 
-  /* Poll array: [0] main compositor, [1] IPC socket, [2] wlr backend display */
+  /* Poll array: [0] main compositor, [1] IPC socket, [2] wlr backend display,
+   * [3] Hyprland event stream, [4] finished frames from the render thread,
+   * [5] icons landed by the loader thread, [6..] in-flight Hyprland IPC
+   * requests */
   int wlr_fd = wlr_backend_get_fd();
-  struct pollfd fds[3];
+  struct pollfd fds[6 + HYPRLAND_IPC_MAX_FDS];
   fds[0].fd = wl_display_get_fd(display);
   fds[0].events = POLLIN;
   fds[1].fd = socket_fd;
   fds[1].events = POLLIN;
   fds[2].fd = wlr_fd; /* -1 if Hyprland backend — poll() ignores fd < 0 */
   fds[2].events = POLLIN;
+  fds[3].events = POLLIN;
+  fds[4].events = POLLIN;
+  fds[5].fd = icons_get_event_fd(); /* -1 if the loader is not running */
+  fds[5].events = POLLIN;
 
   while (running && !should_quit) {
+    /* Refreshed every iteration: the event socket is re-opened on resync */
+    fds[3].fd = hyprland_get_event_fd(); /* -1 if wlr backend */
+    fds[4].fd = render_get_event_fd();   /* -1 until the first frame */
+    int ipc_count = hyprland_ipc_pollfds(&fds[6], HYPRLAND_IPC_MAX_FDS);
+
     /* Prepare read: drain any already-queued events first */
     while (wl_display_prepare_read(display) != 0) {
       if (wl_display_dispatch_pending(display) < 0) {
@@ -807,7 +931,7 @@ static int run_daemon(const char *config_path) {
       }
     }
 
-    int poll_ret = poll(fds, 3, 100);
+    int poll_ret = poll(fds, 6 + ipc_count, 100);
     if (poll_ret < 0) {
       if (errno == EINTR) {
         wl_display_cancel_read(display);
@@ -850,6 +974,20 @@ static int run_daemon(const char *config_path) {
       wlr_backend_dispatch();
     }
 
+    /* Hyprland events: keeps the window model current between shows */
+    if (fds[3].fd >= 0 && (fds[3].revents & (POLLIN | POLLHUP | POLLERR))) {
+      hyprland_dispatch_events();
+    }
+
+    /* Icons landed or desktop entries changed: redraw the placeholders */
+    if (fds[5].fd >= 0 && (fds[5].revents & POLLIN)) {
+      if (icons_dispatch_events() && visible)
+        app_state.needs_render++;
+    }
+
+    /* Async Hyprland IPC: also runs deadlines, so call it every iteration */
+    hyprland_ipc_dispatch(&fds[6], ipc_count);
+
     if (fds[1].revents & POLLIN) {
       while (1) {
         struct sockaddr_un cli_addr;
@@ -875,15 +1013,20 @@ static int run_daemon(const char *config_path) {
           if (buffer[n - 1] == '\n')
             buffer[n - 1] = '\0';
           LOG("Received command: %s", buffer);
-          handle_command(buffer);
+          handle_command(buffer, client);
         }
         close(client);
       }
     }
 
-    /* --- Deferred render: one frame per loop iteration --- */
+    /* --- Present: commit a frame the render thread finished, paced by
+     * the compositor's frame callbacks (also drains fds[4]) --- */
+    render_present(&app_state, visible && is_configured);
+
+    /* --- Deferred render: hand the latest state to the render thread.
+     * Changes arriving while it draws are coalesced into its next frame;
+     * this loop never waits for drawing. */
     if (visible && app_state.needs_render && is_configured) {
-      app_state.needs_render = false;
 
       /* If an error was set after show_switcher() sized the panel,
        * resize to the compact error overlay dimensions first.
@@ -901,13 +1044,15 @@ static int run_daemon(const char *config_path) {
           wl_surface_commit(surface);
           wl_display_roundtrip(display);
           /* The roundtrip dispatched a configure event which set
-           * needs_render = true.  Render on the next iteration
+           * needs_render.  Render on the next iteration
            * with the compositor-confirmed dimensions. */
           continue;
         }
       }
 
-      render_ui(&app_state, app_state.width, app_state.height, output_scale);
+      if (render_submit(&app_state, app_state.width, app_state.height,
+                        output_scale))
+        app_state.needs_render = 0;
     }
   }
 
@@ -920,8 +1065,8 @@ static int run_daemon(const char *config_path) {
 
   cleanup_server(socket_fd);
   input_cleanup();
+  render_cleanup_buffers(); /* Joins the render thread, the icon user */
   icons_cleanup();
-  render_cleanup_buffers();
   app_state_free(&app_state);
   free_config(config);
 
@@ -964,7 +1109,8 @@ static void print_help(const char *prog) {
   printf("  toggle             Toggle the switcher visibility\n");
   printf("  select             Activate the selected window\n");
   printf("  hide               Hide the switcher\n");
-  printf("  quit               Terminate the daemon\n\n");
+  printf("  quit               Terminate the daemon\n");
+  printf("  stats              Print icon cache statistics\n\n");
   printf("Flags (with next, prev, toggle):\n");
   printf("  --mod <key>        Dismiss key (alt, super, ctrl, shift, space, "
          "etc.)\n");
@@ -6,14 +6,19 @@
 #include "icons.h"
 #include <cairo/cairo.h>
 #include <ctype.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <math.h>
 #include <pango/pangocairo.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <sys/eventfd.h>
 #include <sys/mman.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifndef M_PI
@@ -24,6 +29,10 @@
 
 static Config *cfg = NULL;
 
+/* Bumped whenever the config (and so every card's look) changes */
+static unsigned theme_generation = 0;
+
+
 /* Palette for letter icon fallbacks */
 static const uint32_t icon_colors[] = {
     0xe78284ff, /* Red */
@@ -36,7 +45,507 @@ static const uint32_t icon_colors[] = {
 };
 #define NUM_ICON_COLORS (sizeof(icon_colors) / sizeof(icon_colors[0]))
 
-void render_set_config(Config *config) { cfg = config; }
+/* --- Compiled Theme ---
+ *
+ * Everything the draw code needs from the config, resolved once in
+ * render_set_config(): every color as a ready Cairo solid pattern (fixed
+ * alpha factors and selected-state badge overrides applied) plus the
+ * derived geometry.  Draw code reads only from here.
+ */
+
+typedef enum {
+  PAT_BACKGROUND,
+  PAT_PANEL_BORDER,  /* border_color at 30% */
+  PAT_CARD_BG,       /* + selected */
+  PAT_CARD_SELECTED,
+  PAT_BORDER,
+  PAT_TEXT,
+  PAT_MESSAGE,       /* text_color at 50% ("No windows") */
+  PAT_BUNDLE,
+  PAT_BADGE_BG,      /* + selected */
+  PAT_BADGE_BG_SELECTED,
+  PAT_BADGE_TEXT,    /* + selected */
+  PAT_BADGE_TEXT_SELECTED,
+  PAT_LETTER_TEXT,
+  PAT_ERROR_BORDER,
+  PAT_ERROR_HINT,    /* subtext_color at 70% */
+  PAT_ERROR_WATERMARK, /* subtext_color at 40% */
+  PAT_LETTER_BG,     /* + palette index */
+  PAT_COUNT = PAT_LETTER_BG + NUM_ICON_COLORS
+} ThemePattern;
+
+#define CARD_STACK_OFFSET 6 /* Context-mode stack shadow offset */
+
+typedef struct {
+  cairo_pattern_t *pat[PAT_COUNT];
+
+  /* Geometry (logical pixels) */
+  int card_w;
+  int card_h;
+  int card_radius;
+  int card_gap;
+  int padding;
+  int max_cols;
+  int border_width;
+  int panel_radius;  /* Outer panel corners */
+  bool bg_opaque;    /* Panel background has no alpha */
+  bool opaque;       /* Every surface pixel is opaque: XRGB buffers */
+  int icon_size;
+  int icon_radius;
+  double icon_cy;    /* Icon center, below the card's top edge */
+  int margin;        /* Tile margin around a card: room for the border */
+  bool tiles_opaque; /* Tiles may be pre-composited and copied (SOURCE) */
+
+  bool show_workspace_badge;
+  bool show_letter_fallback;
+} Theme;
+
+static Theme theme = {0};
+
+/* FNV-1a */
+static uint64_t hash64(const char *str) {
+  uint64_t h = 14695981039346656037ULL;
+  for (const unsigned char *p = (const unsigned char *)(str ? str : "");
+       *p; p++) {
+    h ^= *p;
+    h *= 1099511628211ULL;
+  }
+  return h;
+}
+
+/* --- Pango Text Resources ---
+ *
+ * Text is laid out through one PangoContext per output scale, created on
+ * first use, with the font description of every text role built once per
+ * config.  Each (context, role) pair owns a single PangoLayout that is
+ * reused for every string drawn in that role: callers set the text, use
+ * the layout and leave it to the pool.
+ *
+ * Pango objects must not be shared between threads, so the main thread,
+ * the render thread and each raster worker have their own set of contexts
+ * and layouts, along with the shaped titles laid out in them (see Title
+ * Shaping Cache); `text_set` points at the calling thread's.  Font
+ * descriptions are built by render_set_config() and only read after.
+ */
+
+typedef enum {
+  FONT_TITLE,     /* Card title */
+  FONT_BADGE,     /* Group count badge */
+  FONT_TAG,       /* Workspace tag */
+  FONT_LETTER,    /* Letter icon fallback */
+  FONT_MESSAGE,   /* "No windows" */
+  FONT_ERROR,     /* Error overlay message */
+  FONT_HINT,      /* Error overlay subtitle */
+  FONT_WATERMARK, /* Error overlay watermark */
+  FONT_COUNT
+} FontRole;
+
+#define MAX_TEXT_CONTEXTS 4 /* Distinct output scales kept at once */
+
+typedef struct {
+  int scale;
+  PangoContext *context;
+  PangoLayout *layouts[FONT_COUNT];
+} TextContext;
+
+typedef struct TitleEntry TitleEntry;
+
+typedef struct {
+  TextContext contexts[MAX_TEXT_CONTEXTS];
+  int count;
+
+  TitleEntry *titles; /* Shaped in these contexts */
+  int title_count;
+  int title_capacity;
+  size_t title_bytes;
+  uint64_t title_tick;
+} TextSet;
+
+static PangoFontDescription *fonts[FONT_COUNT];
+static TextSet main_text_set;   /* Main thread: panel sizing */
+static TextSet render_text_set; /* Render thread: everything drawn */
+static __thread TextSet *text_set = &main_text_set;
+
+/* Creations since the last frame was logged (see render_ui); bumped from
+ * the workers too */
+static int layouts_created = 0;
+static int contexts_created = 0;
+
+#define COUNT_CREATED(n) __atomic_add_fetch(&(n), 1, __ATOMIC_RELAXED)
+
+static int font_size(FontRole role) {
+  int err = cfg ? cfg->error_font_size : 13;
+  int hint = (err * 7 + 5) / 10; /* ~70% of error font */
+  switch (role) {
+  case FONT_TITLE:
+    return cfg ? cfg->title_size : 12;
+  case FONT_BADGE:
+    return 10;
+  case FONT_TAG:
+    return 8;
+  case FONT_LETTER:
+    return cfg ? cfg->icon_letter_size : 28;
+  case FONT_MESSAGE:
+    return 16;
+  case FONT_ERROR:
+    return err;
+  case FONT_HINT:
+    return hint;
+  default:
+    return (hint * 8 + 5) / 10; /* ~80% of hint font */
+  }
+}
+
+static void build_fonts(void) {
+  const char *family = cfg ? cfg->font_family : "Sans";
+  const char *weight_str = cfg ? cfg->font_weight : "Bold";
+  PangoWeight weight = PANGO_WEIGHT_BOLD;
+  if (strcasecmp(weight_str, "Normal") == 0)
+    weight = PANGO_WEIGHT_NORMAL;
+
+  for (int i = 0; i < FONT_COUNT; i++) {
+    fonts[i] = pango_font_description_new();
+    pango_font_description_set_family(fonts[i], family);
+    pango_font_description_set_weight(fonts[i], weight);
+    pango_font_description_set_size(fonts[i], font_size(i) * PANGO_SCALE);
+  }
+}
+
+static void title_set_clear(TextSet *set);
+static void raster_text_sets_free(void);
+
+static void text_context_free(TextContext *tc) {
+  for (int j = 0; j < FONT_COUNT; j++) {
+    if (tc->layouts[j])
+      g_object_unref(tc->layouts[j]);
+  }
+  g_object_unref(tc->context);
+}
+
+static void text_set_free(TextSet *set) {
+  title_set_clear(set); /* Its layouts belong to these contexts */
+  for (int i = 0; i < set->count; i++)
+    text_context_free(&set->contexts[i]);
+  memset(set, 0, sizeof(*set));
+}
+
+/* Drop all contexts, layouts and font descriptions (config change).
+ * Main thread only, with the render thread stopped. */
+static void text_resources_free(void) {
+  text_set_free(&main_text_set);
+  text_set_free(&render_text_set);
+  raster_text_sets_free();
+
+  for (int i = 0; i < FONT_COUNT; i++) {
+    if (fonts[i]) {
+      pango_font_description_free(fonts[i]);
+      fonts[i] = NULL;
+    }
+  }
+}
+
+static TextContext *text_context_for(int scale) {
+  TextSet *set = text_set;
+  for (int i = 0; i < set->count; i++) {
+    if (set->contexts[i].scale == scale)
+      return &set->contexts[i];
+  }
+
+  /* Evict the oldest scale if every slot is taken */
+  if (set->count == MAX_TEXT_CONTEXTS) {
+    text_context_free(&set->contexts[0]);
+    memmove(&set->contexts[0], &set->contexts[1],
+            (MAX_TEXT_CONTEXTS - 1) * sizeof(TextContext));
+    set->count--;
+  }
+
+  /* Take the matrix and font options from a surface like the ones we
+   * draw into, exactly as pango_cairo_create_layout() would */
+  PangoContext *ctx =
+      pango_font_map_create_context(pango_cairo_font_map_get_default());
+  cairo_surface_t *surf = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
+  cairo_t *cr = cairo_create(surf);
+  cairo_scale(cr, scale, scale);
+  pango_cairo_update_context(cr, ctx);
+  cairo_destroy(cr);
+  cairo_surface_destroy(surf);
+  COUNT_CREATED(contexts_created);
+
+  TextContext *tc = &set->contexts[set->count++];
+  memset(tc, 0, sizeof(*tc));
+  tc->scale = scale;
+  tc->context = ctx;
+  return tc;
+}
+
+/* Pooled layout for `role` at `scale`; owned by the pool, do not unref */
+static PangoLayout *text_layout(int scale, FontRole role) {
+  if (!fonts[0])
+    build_fonts();
+
+  TextContext *tc = text_context_for(scale);
+  if (!tc->layouts[role]) {
+    tc->layouts[role] = pango_layout_new(tc->context);
+    pango_layout_set_font_description(tc->layouts[role], fonts[role]);
+    COUNT_CREATED(layouts_created);
+  }
+  return tc->layouts[role];
+}
+
+/* Output scale `cr` draws with (its CTM is a plain scale) */
+static int cr_scale(cairo_t *cr) {
+  cairo_matrix_t m;
+  cairo_get_matrix(cr, &m);
+  int scale = (int)(m.xx + 0.5);
+  return scale > 0 ? scale : 1;
+}
+
+/* Pooled layout matching the scale of the target `cr` draws with */
+static PangoLayout *layout_for(cairo_t *cr, FontRole role) {
+  return text_layout(cr_scale(cr), role);
+}
+
+/* --- Title Shaping Cache ---
+ *
+ * Shaping and ellipsizing a title is the most expensive text operation on
+ * a card, and titles rarely change.  Each (title, width, scale) gets its
+ * own fully laid-out PangoLayout, kept under a memory budget with LRU
+ * eviction.  The font description is implied: the cache is flushed
+ * whenever the fonts are rebuilt.
+ *
+ * The layouts belong to the contexts of the thread that shaped them, so
+ * every text set has its own cache, and a raster worker keeps the titles
+ * of the cards it drew.  Flushes and invalidations apply to all of them
+ * between frames, while no raster job runs.
+ */
+
+#define TITLE_CACHE_BUDGET (512 * 1024) /* Approximate bytes */
+#define TITLE_LAYOUT_OVERHEAD 1024     /* Rough per-layout cost... */
+#define TITLE_BYTES_PER_CHAR 48        /* ...plus glyphs/attrs per byte */
+
+struct TitleEntry {
+  uint64_t hash;      /* FNV-1a of the title */
+  char *title;
+  uint64_t window_id; /* Window it was last shaped for */
+  int width;          /* Pango units */
+  int scale;
+  PangoLayout *layout;
+  size_t cost;
+  uint64_t last_used; /* LRU tick */
+};
+
+static void title_entry_remove(TextSet *set, int i) {
+  TitleEntry *e = &set->titles[i];
+  g_object_unref(e->layout);
+  free(e->title);
+  set->title_bytes -= e->cost;
+  set->titles[i] = set->titles[--set->title_count];
+}
+
+static void title_set_clear(TextSet *set) {
+  while (set->title_count > 0)
+    title_entry_remove(set, set->title_count - 1);
+  free(set->titles);
+  set->titles = NULL;
+  set->title_capacity = 0;
+  set->title_bytes = 0;
+}
+
+/* Forget every title `set` shaped for `window_id` */
+static void title_set_invalidate(TextSet *set, uint64_t window_id) {
+  for (int i = set->title_count - 1; i >= 0; i--) {
+    if (set->titles[i].window_id == window_id)
+      title_entry_remove(set, i);
+  }
+}
+
+/* Evict least recently used entries until `cost` more bytes fit */
+static void title_set_make_room(TextSet *set, size_t cost) {
+  while (set->title_count > 0 &&
+         set->title_bytes + cost > TITLE_CACHE_BUDGET) {
+    int lru = 0;
+    for (int i = 1; i < set->title_count; i++) {
+      if (set->titles[i].last_used < set->titles[lru].last_used)
+        lru = i;
+    }
+    title_entry_remove(set, lru);
+  }
+}
+
+/* Set `text` on `layout` ellipsized and centered at `width` Pango units,
+ * and shape it now so that later draws only replay glyphs */
+static void title_shape(PangoLayout *layout, const char *text, int width) {
+  pango_layout_set_width(layout, width);
+  pango_layout_set_ellipsize(layout, PANGO_ELLIPSIZE_END);
+  pango_layout_set_alignment(layout, PANGO_ALIGN_CENTER);
+  pango_layout_set_text(layout, text, -1);
+
+  int lw, lh;
+  pango_layout_get_pixel_size(layout, &lw, &lh);
+}
+
+/*
+ * Shaped, ellipsized, centered layout of `win`'s title at `width` pixels,
+ * from the calling thread's cache.  Owned by the cache (or the layout pool
+ * if caching fails): do not unref, and use it before the next title.
+ */
+static PangoLayout *title_layout(int scale, WindowInfo *win, int width) {
+  TextSet *set = text_set;
+  const char *text = win->title ? win->title : "";
+  uint64_t hash = hash64(text);
+  width *= PANGO_SCALE;
+
+  for (int i = 0; i < set->title_count; i++) {
+    TitleEntry *e = &set->titles[i];
+    if (e->hash == hash && e->width == width && e->scale == scale &&
+        strcmp(e->title, text) == 0) {
+      e->last_used = ++set->title_tick;
+      e->window_id = win->id;
+      return e->layout;
+    }
+  }
+
+  /* This window's previous title will not be drawn again */
+  title_set_invalidate(set, win->id);
+
+  PangoLayout *layout = text_layout(scale, FONT_TITLE);
+  size_t len = strlen(text);
+  size_t cost = sizeof(TitleEntry) + len + 1 + TITLE_LAYOUT_OVERHEAD +
+                len * TITLE_BYTES_PER_CHAR;
+  if (cost <= TITLE_CACHE_BUDGET) {
+    title_set_make_room(set, cost);
+    if (set->title_count >= set->title_capacity) {
+      int cap = set->title_capacity ? set->title_capacity * 2 : 32;
+      TitleEntry *n = realloc(set->titles, cap * sizeof(TitleEntry));
+      if (n) {
+        set->titles = n;
+        set->title_capacity = cap;
+      }
+    }
+    char *copy = strdup(text);
+    if (set->title_count < set->title_capacity && copy) {
+      layout = pango_layout_new(text_context_for(scale)->context);
+      pango_layout_set_font_description(layout, fonts[FONT_TITLE]);
+      COUNT_CREATED(layouts_created);
+      set->titles[set->title_count++] = (TitleEntry){
+          .hash = hash,
+          .title = copy,
+          .window_id = win->id,
+          .width = width,
+          .scale = scale,
+          .layout = layout,
+          .cost = cost,
+          .last_used = ++set->title_tick,
+      };
+      set->title_bytes += cost;
+    } else {
+      free(copy);
+    }
+  }
+
+  title_shape(layout, text, width);
+  return layout;
+}
+
+static cairo_pattern_t *solid(uint32_t color, double alpha_scale) {
+  double r, g, b, a;
+  color_to_rgba(color, &r, &g, &b, &a);
+  return cairo_pattern_create_rgba(r, g, b, a * alpha_scale);
+}
+
+/* Same, but replacing the color's own alpha */
+static cairo_pattern_t *solid_with_alpha(uint32_t color, double alpha) {
+  double r, g, b, a;
+  color_to_rgba(color, &r, &g, &b, &a);
+  return cairo_pattern_create_rgba(r, g, b, alpha);
+}
+
+static void theme_free(void) {
+  for (int i = 0; i < PAT_COUNT; i++) {
+    if (theme.pat[i])
+      cairo_pattern_destroy(theme.pat[i]);
+  }
+  memset(&theme, 0, sizeof(theme));
+}
+
+static void theme_compile(const Config *c) {
+  theme_free();
+
+  theme.pat[PAT_BACKGROUND] = solid(c->background, 1.0);
+  theme.pat[PAT_PANEL_BORDER] = solid_with_alpha(c->border_color, 0.3);
+  theme.pat[PAT_CARD_BG] = solid(c->card_bg, 1.0);
+  theme.pat[PAT_CARD_SELECTED] = solid(c->card_selected, 1.0);
+  theme.pat[PAT_BORDER] = solid(c->border_color, 1.0);
+  theme.pat[PAT_TEXT] = solid(c->text_color, 1.0);
+  theme.pat[PAT_MESSAGE] = solid_with_alpha(c->text_color, 0.5);
+  theme.pat[PAT_BUNDLE] = solid(c->bundle_bg, 1.0);
+  theme.pat[PAT_BADGE_BG] = solid(c->badge_bg, 1.0);
+  theme.pat[PAT_BADGE_TEXT] = solid(c->badge_text_color, 1.0);
+
+  /* Selected-state badge overrides (fall back to standard if unset) */
+  theme.pat[PAT_BADGE_BG_SELECTED] = solid(
+      c->has_badge_bg_selected ? c->badge_bg_selected : c->badge_bg, 1.0);
+  theme.pat[PAT_BADGE_TEXT_SELECTED] =
+      solid(c->has_badge_text_color_selected ? c->badge_text_color_selected
+                                             : c->badge_text_color,
+            1.0);
+
+  theme.pat[PAT_LETTER_TEXT] = cairo_pattern_create_rgba(1, 1, 1, 1);
+  theme.pat[PAT_ERROR_BORDER] =
+      cairo_pattern_create_rgba(0.91, 0.30, 0.24, 0.9); /* #E84C3D */
+  theme.pat[PAT_ERROR_HINT] = solid(c->subtext_color, 0.7);
+  theme.pat[PAT_ERROR_WATERMARK] = solid(c->subtext_color, 0.4);
+  for (size_t i = 0; i < NUM_ICON_COLORS; i++)
+    theme.pat[PAT_LETTER_BG + i] = solid(icon_colors[i], 1.0);
+
+  theme.card_w = c->card_width;
+  theme.card_h = c->card_height;
+  theme.card_radius = c->card_radius;
+  theme.card_gap = c->card_gap;
+  theme.padding = c->padding;
+  theme.max_cols = c->max_cols > 0 ? c->max_cols : 1;
+  theme.border_width = c->border_width;
+  /* Square cards get a square panel, which can then be fully opaque */
+  theme.panel_radius = c->card_radius > 0 ? c->card_radius + 4 : 0;
+  theme.icon_size = c->icon_size;
+  theme.icon_radius = c->icon_radius;
+  theme.icon_cy = 10 + 20 + 10 + c->icon_size / 2.0;
+  theme.margin = (c->border_width + 1) / 2 + 1;
+  theme.show_workspace_badge = c->show_workspace_badge;
+  theme.show_letter_fallback = c->show_letter_fallback;
+
+  /* Opaque tiles replace the pixels under them, so they must not overlap
+   * a neighbouring card or reach the panel's rounded corners/border */
+  int reach = CARD_STACK_OFFSET + theme.margin;
+  theme.tiles_opaque = theme.card_gap >= reach + theme.margin &&
+                       theme.padding - reach >= theme.panel_radius + 1;
+
+  /* Everything is drawn over the background (the panel border too), so an
+   * opaque background leaves only the rounded corners translucent */
+  theme.bg_opaque = (c->background & 0xFF) == 0xFF;
+  theme.opaque = theme.bg_opaque && theme.panel_radius == 0;
+}
+
+static void render_thread_stop(void);
+
+void render_set_config(Config *config) {
+  static Config defaults;
+  render_thread_stop(); /* It reads the theme and fonts we replace */
+  if (!config) {
+    Config *d = get_default_config();
+    if (d) {
+      defaults = *d;
+      free_config(d);
+    }
+    config = &defaults;
+  }
+
+  cfg = config;
+  theme_generation++;
+  theme_compile(cfg);
+  text_resources_free(); /* Layouts are rebuilt with the new fonts on use */
+  build_fonts();
+}
 
 int create_shm_file(off_t size) {
   int fd = -1;
@@ -66,26 +575,6 @@ static unsigned int hash_string(const char *str) {
   return hash;
 }
 
-/* Helper to start Pango layout with config font */
-static PangoLayout *create_layout(cairo_t *cr, int size) {
-  PangoLayout *layout = pango_cairo_create_layout(cr);
-  PangoFontDescription *desc = pango_font_description_new();
-
-  const char *family = cfg ? cfg->font_family : "Sans";
-  const char *weight_str = cfg ? cfg->font_weight : "Bold";
-  PangoWeight weight = PANGO_WEIGHT_BOLD;
-  if (strcasecmp(weight_str, "Normal") == 0)
-    weight = PANGO_WEIGHT_NORMAL;
-
-  pango_font_description_set_family(desc, family);
-  pango_font_description_set_weight(desc, weight);
-  pango_font_description_set_size(desc, size * PANGO_SCALE);
-
-  pango_layout_set_font_description(layout, desc);
-  pango_font_description_free(desc);
-  return layout;
-}
-
 static void draw_rounded_rect(cairo_t *cr, double x, double y, double w,
                               double h, double r) {
   cairo_new_path(cr); /* Critical: reset path */
@@ -102,43 +591,304 @@ static void draw_rounded_rect(cairo_t *cr, double x, double y, double w,
   cairo_close_path(cr);
 }
 
+/* --- Card Chrome Sprites ---
+ *
+ * The card background, selection border, context-mode stack and badge
+ * pills look the same on every card of a theme and scale.  They are
+ * rasterized once as nine-slice sprites (fixed corners, one stretchable
+ * row/column in between) and then composited with plain blits, so no
+ * anti-aliased arcs are drawn per card.
+ */
+
+typedef struct {
+  cairo_surface_t *surface;      /* Natural-size raster, physical px */
+  int w, h;
+  int left, right, top, bottom;  /* Fixed borders; the rest stretches */
+  cairo_pattern_t *slice[9];     /* Row-major; NULL for empty slices */
+} Sprite;
+
+typedef enum { PILL_COUNT, PILL_TAG, PILL_KINDS } PillKind;
+
+typedef struct {
+  int scale;          /* 0 = nothing built yet */
+  unsigned theme_gen;
+  Sprite card[4];     /* [grouped * 2 + selected] */
+  Sprite pill[PILL_KINDS][2]; /* [kind][selected] */
+  int pill_h[PILL_KINDS];     /* Logical height the pills were built for */
+} Chrome;
+
+static Chrome chrome = {0};
+
+static void sprite_free(Sprite *sp) {
+  for (int i = 0; i < 9; i++) {
+    if (sp->slice[i])
+      cairo_pattern_destroy(sp->slice[i]);
+  }
+  if (sp->surface)
+    cairo_surface_destroy(sp->surface);
+  memset(sp, 0, sizeof(*sp));
+}
+
+static void chrome_free(void) {
+  for (int i = 0; i < 4; i++)
+    sprite_free(&chrome.card[i]);
+  for (int k = 0; k < PILL_KINDS; k++)
+    for (int i = 0; i < 2; i++)
+      sprite_free(&chrome.pill[k][i]);
+  memset(&chrome, 0, sizeof(chrome));
+}
+
+/* Cut `sp->surface` into its nine slices. The middle slices are a single
+ * row/column (the first stretchable one, or the last fixed one if the
+ * sprite has none) padded out when drawn. */
+static void sprite_slice(Sprite *sp) {
+  int xs[3] = {0, sp->left < sp->w - sp->right ? sp->left : sp->left - 1,
+               sp->w - sp->right};
+  int ws[3] = {sp->left, 1, sp->right};
+  int ys[3] = {0, sp->top < sp->h - sp->bottom ? sp->top : sp->top - 1,
+               sp->h - sp->bottom};
+  int hs[3] = {sp->top, 1, sp->bottom};
+
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      if (ws[c] <= 0 || hs[r] <= 0 || xs[c] < 0 || ys[r] < 0)
+        continue;
+      cairo_surface_t *sub = cairo_surface_create_for_rectangle(
+          sp->surface, xs[c], ys[r], ws[c], hs[r]);
+      cairo_pattern_t *pat = cairo_pattern_create_for_surface(sub);
+      cairo_pattern_set_extend(pat, CAIRO_EXTEND_PAD);
+      cairo_pattern_set_filter(pat, CAIRO_FILTER_NEAREST);
+      cairo_surface_destroy(sub);
+      sp->slice[r * 3 + c] = pat;
+    }
+  }
+}
+
+/* New transparent sprite of w x h physical px, with a cairo_t set up for
+ * drawing in logical units */
+static cairo_t *sprite_begin(Sprite *sp, int w, int h, int scale) {
+  sp->surface = cairo_image_surface_create(CAIRO_FORMAT_ARGB32, w, h);
+  if (cairo_surface_status(sp->surface) != CAIRO_STATUS_SUCCESS) {
+    sprite_free(sp);
+    return NULL;
+  }
+  sp->w = w;
+  sp->h = h;
+  cairo_t *cr = cairo_create(sp->surface);
+  cairo_scale(cr, scale, scale);
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+  return cr;
+}
+
+/*
+ * Blit `sp` stretched to the logical rect (x, y, w, h) of `cr`, which must
+ * map it to whole device pixels.  Returns false (drawing nothing) if the
+ * sprite is missing or the rect is smaller than its fixed borders.
+ */
+static bool sprite_draw(cairo_t *cr, const Sprite *sp, double x, double y,
+                        double w, double h) {
+  if (!sp->surface)
+    return false;
+
+  double x1 = x, y1 = y, x2 = x + w, y2 = y + h;
+  cairo_user_to_device(cr, &x1, &y1);
+  cairo_user_to_device(cr, &x2, &y2);
+  int dx = (int)lround(x1), dy = (int)lround(y1);
+  int dw = (int)lround(x2) - dx, dh = (int)lround(y2) - dy;
+  if (dw < sp->left + sp->right || dh < sp->top + sp->bottom)
+    return false;
+
+  int xd[4] = {dx, dx + sp->left, dx + dw - sp->right, dx + dw};
+  int yd[4] = {dy, dy + sp->top, dy + dh - sp->bottom, dy + dh};
+
+  cairo_save(cr);
+  cairo_identity_matrix(cr);
+  for (int r = 0; r < 3; r++) {
+    for (int c = 0; c < 3; c++) {
+      cairo_pattern_t *pat = sp->slice[r * 3 + c];
+      int sw = xd[c + 1] - xd[c], sh = yd[r + 1] - yd[r];
+      if (!pat || sw <= 0 || sh <= 0)
+        continue;
+      /* Move the target, not the pattern: slices are shared by threads */
+      cairo_identity_matrix(cr);
+      cairo_translate(cr, xd[c], yd[r]);
+      cairo_set_source(cr, pat);
+      cairo_rectangle(cr, 0, 0, sw, sh);
+      cairo_fill(cr);
+    }
+  }
+  cairo_restore(cr);
+  return true;
+}
+
+/* Vector card chrome: stack (context mode), background, selection border */
+static void draw_card_chrome(cairo_t *cr, double x, double y, double w,
+                             double h, bool grouped, bool selected) {
+  int r = theme.card_radius;
+
+  if (grouped) {
+    cairo_set_source(cr, theme.pat[PAT_BUNDLE]);
+    draw_rounded_rect(cr, x + CARD_STACK_OFFSET, y + CARD_STACK_OFFSET, w, h,
+                      r);
+    cairo_fill(cr);
+
+    draw_rounded_rect(cr, x + CARD_STACK_OFFSET / 2, y + CARD_STACK_OFFSET / 2,
+                      w, h, r);
+    cairo_fill(cr);
+  }
+
+  cairo_set_source(cr, theme.pat[PAT_CARD_BG + selected]);
+  draw_rounded_rect(cr, x, y, w, h, r);
+  cairo_fill(cr);
+
+  if (selected) {
+    cairo_set_source(cr, theme.pat[PAT_BORDER]);
+    cairo_set_line_width(cr, theme.border_width);
+    draw_rounded_rect(cr, x, y, w, h, r);
+    cairo_stroke(cr);
+  }
+}
+
+/* Drop sprites built for another theme or scale.  While raster workers
+ * run, sprites are neither built nor dropped: callers get `no_sprite`
+ * (vector fallback) for any sprite chrome_prepare() did not build. */
+static const Sprite no_sprite = {0};
+static bool chrome_frozen = false;
+
+static bool chrome_check(int scale) {
+  if (chrome.scale != scale || chrome.theme_gen != theme_generation) {
+    if (chrome_frozen)
+      return false;
+    chrome_free();
+    chrome.scale = scale;
+    chrome.theme_gen = theme_generation;
+  }
+  return true;
+}
+
+/*
+ * Card chrome as a sprite covering the card plus its stack and border
+ * margin.  Caps hold the corner arcs (and the stack offset on the far
+ * sides); everything in between is a straight edge or flat fill, so the
+ * sprite is built at the smallest card size with a one-unit middle.
+ */
+static const Sprite *card_sprite(int scale, bool grouped, bool selected) {
+  if (!chrome_check(scale))
+    return &no_sprite;
+  Sprite *sp = &chrome.card[grouped * 2 + selected];
+  if (sp->surface || chrome_frozen)
+    return sp;
+
+  int m = theme.margin;
+  int near = m + theme.card_radius + 1;
+  int far = theme.card_radius + 1 + CARD_STACK_OFFSET + m;
+  int size = near + 1 + far; /* Logical sprite size */
+
+  cairo_t *cr = sprite_begin(sp, size * scale, size * scale, scale);
+  if (!cr)
+    return sp;
+  int card = size - 2 * m - CARD_STACK_OFFSET;
+  draw_card_chrome(cr, m, m, card, card, grouped, selected);
+  cairo_destroy(cr);
+
+  sp->left = sp->top = near * scale;
+  sp->right = sp->bottom = far * scale;
+  sprite_slice(sp);
+  return sp;
+}
+
+/*
+ * Badge background sprite of logical height `h`: the count badge is a
+ * pill (radius h/2, built as the circle a single digit gets), the
+ * workspace tag a rounded rect (radius 4).  Only the width stretches.
+ */
+static const Sprite *pill_sprite(int scale, PillKind kind, bool selected,
+                                 int h) {
+  if (!chrome_check(scale) || (chrome_frozen && chrome.pill_h[kind] != h))
+    return &no_sprite;
+  if (chrome.pill_h[kind] != h) {
+    sprite_free(&chrome.pill[kind][0]);
+    sprite_free(&chrome.pill[kind][1]);
+    chrome.pill_h[kind] = h;
+  }
+  Sprite *sp = &chrome.pill[kind][selected];
+  if (sp->surface || chrome_frozen)
+    return sp;
+
+  double radius = kind == PILL_COUNT ? h / 2.0 : 4.0;
+  int w = kind == PILL_COUNT ? h : 2 * (4 + 1) + 1;
+
+  cairo_t *cr = sprite_begin(sp, w * scale, h * scale, scale);
+  if (!cr)
+    return sp;
+  cairo_set_source(cr, theme.pat[PAT_BADGE_BG + selected]);
+  draw_rounded_rect(cr, 0, 0, w, h, radius);
+  cairo_fill(cr);
+  cairo_destroy(cr);
+
+  if (kind == PILL_COUNT) {
+    sp->left = sp->right = (h * scale) / 2;
+  } else {
+    sp->left = sp->right = (4 + 1) * scale;
+  }
+  sp->top = h * scale; /* No vertical stretch */
+  sp->bottom = 0;
+  sprite_slice(sp);
+  return sp;
+}
+
+/* Build every sprite a card at `scale` can use, so the raster workers find
+ * them ready.  Badge heights are one text line plus draw_card's padding. */
+static void chrome_prepare(int scale) {
+  static const FontRole roles[PILL_KINDS] = {FONT_BADGE, FONT_TAG};
+  static const char *samples[PILL_KINDS] = {"0", "[0]"};
+
+  for (int i = 0; i < 4; i++)
+    card_sprite(scale, i / 2, i % 2);
+  for (int k = 0; k < PILL_KINDS; k++) {
+    PangoLayout *layout = text_layout(scale, roles[k]);
+    pango_layout_set_text(layout, samples[k], -1);
+    int lw, lh;
+    pango_layout_get_pixel_size(layout, &lw, &lh);
+    for (int sel = 0; sel < 2; sel++)
+      pill_sprite(scale, k, sel, lh + 4 * 2);
+  }
+}
+
 static void draw_letter_icon(cairo_t *cr, const char *cls, double cx, double cy,
-                             int size, int radius, int letter_size) {
+                             int size, int radius) {
   cairo_save(cr);
   cairo_new_path(cr);
 
   /* Background */
-  uint32_t color = icon_colors[hash_string(cls) % NUM_ICON_COLORS];
-  double r, g, b, a;
-  color_to_rgba(color, &r, &g, &b, &a);
-
-  cairo_set_source_rgba(cr, r, g, b, a);
+  cairo_set_source(cr,
+                   theme.pat[PAT_LETTER_BG + hash_string(cls) % NUM_ICON_COLORS]);
   draw_rounded_rect(cr, cx - size / 2.0, cy - size / 2.0, size, size, radius);
   cairo_fill(cr);
 
   /* Letter */
   char letter[2] = {cls && cls[0] ? toupper(cls[0]) : '?', 0};
-  PangoLayout *layout = create_layout(cr, letter_size);
+  PangoLayout *layout = layout_for(cr, FONT_LETTER);
   pango_layout_set_text(layout, letter, -1);
 
   int lw, lh;
   pango_layout_get_pixel_size(layout, &lw, &lh);
 
-  cairo_set_source_rgb(cr, 1, 1, 1);
+  cairo_set_source(cr, theme.pat[PAT_LETTER_TEXT]);
   cairo_move_to(cr, (int)(cx - lw / 2.0), (int)(cy - lh / 2.0));
   pango_cairo_show_layout(cr, layout);
 
-  g_object_unref(layout);
   cairo_restore(cr);
 }
 
-static void draw_icon(cairo_t *cr, const char *cls, double cx, double cy) {
-  int size = cfg ? cfg->icon_size : 64;
-  int radius = cfg ? cfg->icon_radius : 12;
+/* Draw `icon` (from icons_lookup(), may be NULL) or the letter fallback */
+static void draw_icon(cairo_t *cr, cairo_surface_t *icon, const char *cls,
+                      double cx, double cy) {
+  int size = theme.icon_size;
+  int radius = theme.icon_radius;
 
   cairo_save(cr);
 
-  cairo_surface_t *icon = load_app_icon(cls, size);
   if (icon && cairo_surface_status(icon) == CAIRO_STATUS_SUCCESS) {
     /* Clip mask */
     draw_rounded_rect(cr, cx - size / 2.0, cy - size / 2.0, size, size, radius);
@@ -146,20 +896,42 @@ static void draw_icon(cairo_t *cr, const char *cls, double cx, double cy) {
 
     cairo_set_source_surface(cr, icon, cx - size / 2.0, cy - size / 2.0);
     cairo_paint(cr);
-    cairo_surface_destroy(icon);
-  } else {
+  } else if (theme.show_letter_fallback) {
     /* Fallback */
-    if (icon)
-      cairo_surface_destroy(icon);
-    if (!cfg || cfg->show_letter_fallback) {
-      draw_letter_icon(cr, cls, cx, cy, size, radius,
-                       cfg ? cfg->icon_letter_size : 28);
-    }
+    draw_letter_icon(cr, cls, cx, cy, size, radius);
   }
 
   cairo_restore(cr);
 }
 
+/* --- Card Assets ---
+ *
+ * What a card takes from the shared icon cache, looked up on the render
+ * thread before drawing so that drawing, possibly on a raster worker, does
+ * not touch the cache.  The icon is referenced: the cache may evict it
+ * while a worker still draws.  Titles are not assets: Pango objects stay
+ * on the thread that made them, so the drawing thread takes the title
+ * from its own cache (see draw_card).
+ */
+
+typedef struct {
+  cairo_surface_t *icon; /* NULL: letter fallback */
+  bool icon_pending;     /* icon is still loading: a placeholder is drawn */
+  unsigned icon_gen;     /* icons_loaded_generation() before the lookup */
+} CardAssets;
+
+static void card_assets_get(WindowInfo *win, int scale, CardAssets *a) {
+  a->icon_gen = icons_loaded_generation();
+  a->icon = icons_lookup(win->class_name, theme.icon_size, scale,
+                         &a->icon_pending);
+}
+
+static void card_assets_put(CardAssets *a) {
+  if (a->icon)
+    cairo_surface_destroy(a->icon);
+  a->icon = NULL;
+}
+
 /* --- Workspace Tag Formatting --- */
 
 /*
@@ -254,22 +1026,23 @@ static int letter_tracker_assign(LetterTracker *lt, const char *name) {
  *      - 101st (idx 100): "[M:∞]"  (always, even if floating)
  *      - >101 (idx >100): easter egg string
  *
- * Returns a heap-allocated string. Caller must free().
+ * Writes the tag into `buf` (CARD_TAG_MAX bytes is always enough).
  */
-static char *format_workspace_tag(WindowInfo *win, LetterTracker *lt) {
+static void format_workspace_tag(WindowInfo *win, LetterTracker *lt,
+                                 char *buf, size_t size) {
   const char *name = win->workspace_name;
 
  /* --- Rule 1: Special workspaces --- */
   if (name && strncmp(name, "special:", 8) == 0) {
-    return win->is_floating ? strdup("[S:F]") : strdup("[S]");
+    snprintf(buf, size, "%s", win->is_floating ? "[S:F]" : "[S]");
+    return;
   }
 
   /* --- Rule 2: Standard numbered workspaces --- */
   if (!name || !*name || is_numeric_name(name)) {
-    char buf[32];
-    snprintf(buf, sizeof(buf), "[%s%d]",
+    snprintf(buf, size, "[%s%d]",
              win->is_floating ? "F:" : "", win->workspace_id);
-    return strdup(buf);
+    return;
   }
 
   /* --- Rule 3: Named workspaces --- */
@@ -278,120 +1051,69 @@ static char *format_workspace_tag(WindowInfo *win, LetterTracker *lt) {
 
   /* What if User is a stubborn ass > 101 occurrences (index > 100) */
   if (idx > 100) {
-    return strdup("Fuck you user, pick a damn name with different letters");
+    snprintf(buf, size, "%s",
+             "Fuck you user, pick a damn name with different letters");
+    return;
   }
 
   /* Exactly 101st (index 100): infinity */
   if (idx == 100) {
-    char buf[32];
-    snprintf(buf, sizeof(buf), "[%c:\xe2\x88\x9e]", letter); /* ∞ is UTF-8: E2 88 9E */
-    return strdup(buf);
+    snprintf(buf, size, "[%c:\xe2\x88\x9e]", letter); /* ∞ is UTF-8: E2 88 9E */
+    return;
   }
 
   /* Index 0: just the letter */
   if (idx == 0) {
-    char buf[16];
     if (win->is_floating)
-      snprintf(buf, sizeof(buf), "[%c:F]", letter);
+      snprintf(buf, size, "[%c:F]", letter);
     else
-      snprintf(buf, sizeof(buf), "[%c]", letter);
-    return strdup(buf);
+      snprintf(buf, size, "[%c]", letter);
+    return;
   }
 
   /* Index 1..99: letter + index */
-  char buf[32];
   if (win->is_floating)
-    snprintf(buf, sizeof(buf), "[%c:%d:F]", letter, idx);
+    snprintf(buf, size, "[%c:%d:F]", letter, idx);
   else
-    snprintf(buf, sizeof(buf), "[%c:%d]", letter, idx);
-  return strdup(buf);
+    snprintf(buf, size, "[%c:%d]", letter, idx);
 }
 
 /* Module-level tracker, zeroed each render pass */
 static LetterTracker g_letter_tracker;
 
 static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
-                      bool selected) {
+                      bool selected, const char *ws_text,
+                      const CardAssets *assets) {
   cairo_save(cr);
 
-  double bg_r, bg_g, bg_b, bg_a;
-  double sel_r, sel_g, sel_b, sel_a;
-  double brd_r, brd_g, brd_b, brd_a;
-  double txt_r, txt_g, txt_b, txt_a;
-  double bnd_r, bnd_g, bnd_b, bnd_a;
-  double bdg_r, bdg_g, bdg_b, bdg_a;
-  double bdt_r, bdt_g, bdt_b, bdt_a;
-
-  if (cfg) {
-    color_to_rgba(cfg->card_bg, &bg_r, &bg_g, &bg_b, &bg_a);
-    color_to_rgba(cfg->card_selected, &sel_r, &sel_g, &sel_b, &sel_a);
-    color_to_rgba(cfg->border_color, &brd_r, &brd_g, &brd_b, &brd_a);
-    color_to_rgba(cfg->text_color, &txt_r, &txt_g, &txt_b, &txt_a);
-    color_to_rgba(cfg->bundle_bg, &bnd_r, &bnd_g, &bnd_b, &bnd_a);
-    color_to_rgba(cfg->badge_bg, &bdg_r, &bdg_g, &bdg_b, &bdg_a);
-    color_to_rgba(cfg->badge_text_color, &bdt_r, &bdt_g, &bdt_b, &bdt_a);
-
-    /* Selected-state badge overrides (fall back to standard if unset) */
-    if (selected && cfg->has_badge_bg_selected)
-      color_to_rgba(cfg->badge_bg_selected, &bdg_r, &bdg_g, &bdg_b, &bdg_a);
-    if (selected && cfg->has_badge_text_color_selected)
-      color_to_rgba(cfg->badge_text_color_selected, &bdt_r, &bdt_g, &bdt_b, &bdt_a);
-  }
-
-  int w = cfg ? cfg->card_width : 200;
-  int h = cfg ? cfg->card_height : 160;
-  int r = cfg ? cfg->card_radius : 12;
-
-  /* Stack effect (Context Mode) */
-  if (win->group_count > 1) {
-    cairo_set_source_rgba(cr, bnd_r, bnd_g, bnd_b, bnd_a);
-    draw_rounded_rect(cr, x + 6, y + 6, w, h, r);
-    cairo_fill(cr);
-
-    cairo_set_source_rgba(cr, bnd_r, bnd_g, bnd_b, bnd_a);
-    draw_rounded_rect(cr, x + 3, y + 3, w, h, r);
-    cairo_fill(cr);
-  }
-
-  /* Main Card */
-  if (selected)
-    cairo_set_source_rgba(cr, sel_r, sel_g, sel_b, sel_a);
-  else
-    cairo_set_source_rgba(cr, bg_r, bg_g, bg_b, bg_a);
-
-  draw_rounded_rect(cr, x, y, w, h, r);
-  cairo_fill(cr);
+  int w = theme.card_w;
+  int h = theme.card_h;
+  cairo_pattern_t *badge_bg = theme.pat[PAT_BADGE_BG + selected];
+  cairo_pattern_t *badge_text = theme.pat[PAT_BADGE_TEXT + selected];
 
-  /* Border */
-  if (selected) {
-    cairo_set_source_rgba(cr, brd_r, brd_g, brd_b, brd_a);
-    cairo_set_line_width(cr, cfg ? cfg->border_width : 2);
-    draw_rounded_rect(cr, x, y, w, h, r);
-    cairo_stroke(cr);
-  }
+  /* Chrome: stack effect (context mode), card background, border */
+  bool grouped = win->group_count > 1;
+  int scale = cr_scale(cr);
+  if (!sprite_draw(cr, card_sprite(scale, grouped, selected), x - theme.margin,
+                   y - theme.margin, w + CARD_STACK_OFFSET + 2 * theme.margin,
+                   h + CARD_STACK_OFFSET + 2 * theme.margin))
+    draw_card_chrome(cr, x, y, w, h, grouped, selected);
 
   /* Title */
-  PangoLayout *title = create_layout(cr, cfg ? cfg->title_size : 12);
-  pango_layout_set_width(title, (w - 20) * PANGO_SCALE);
-  pango_layout_set_ellipsize(title, PANGO_ELLIPSIZE_END);
-  pango_layout_set_alignment(title, PANGO_ALIGN_CENTER);
-  pango_layout_set_text(title, win->title, -1);
-
-  cairo_set_source_rgba(cr, txt_r, txt_g, txt_b, txt_a);
+  PangoLayout *title = title_layout(scale, win, w - 20);
+  cairo_set_source(cr, theme.pat[PAT_TEXT]);
   cairo_move_to(cr, (int)(x + 10), (int)(y + 10));
   pango_cairo_show_layout(cr, title);
-  g_object_unref(title);
 
   /* Icon */
-  draw_icon(cr, win->class_name, x + w / 2.0,
-            y + 10 + 20 + 10 + (cfg ? cfg->icon_size / 2.0 : 32));
+  draw_icon(cr, assets->icon, win->class_name, x + w / 2.0, y + theme.icon_cy);
 
   /* Badge (Count) — dynamically sized rounded square */
   if (win->group_count > 1) {
     char count[12];
     snprintf(count, sizeof(count), "%d", win->group_count);
 
-    PangoLayout *bl = create_layout(cr, 10);
+    PangoLayout *bl = layout_for(cr, FONT_BADGE);
     pango_layout_set_text(bl, count, -1);
 
     int bw, bh;
@@ -407,23 +1129,23 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
     double cnt_y = y + h - cnt_h - 6;
 
     /* Badge BG — pill shape */
-    cairo_set_source_rgba(cr, bdg_r, bdg_g, bdg_b, bdg_a);
-    draw_rounded_rect(cr, cnt_x, cnt_y, cnt_w, cnt_h, cnt_h / 2.0);
-    cairo_fill(cr);
+    if (!sprite_draw(cr, pill_sprite(scale, PILL_COUNT, selected, cnt_h),
+                     cnt_x, cnt_y, cnt_w, cnt_h)) {
+      cairo_set_source(cr, badge_bg);
+      draw_rounded_rect(cr, cnt_x, cnt_y, cnt_w, cnt_h, cnt_h / 2.0);
+      cairo_fill(cr);
+    }
 
     /* Badge Text — pixel-snapped center */
-    cairo_set_source_rgba(cr, bdt_r, bdt_g, bdt_b, bdt_a);
+    cairo_set_source(cr, badge_text);
     cairo_move_to(cr, (int)(cnt_x + (cnt_w - bw) / 2.0),
                       (int)(cnt_y + (cnt_h - bh) / 2.0));
     pango_cairo_show_layout(cr, bl);
-    g_object_unref(bl);
   }
 
   /* Workspace Badge (bottom-left) — dynamically sized rounded square */
-  if (cfg && cfg->show_workspace_badge) {
-    char *ws_text = format_workspace_tag(win, &g_letter_tracker);
-
-    PangoLayout *wl = create_layout(cr, 8);
+  if (theme.show_workspace_badge) {
+    PangoLayout *wl = layout_for(cr, FONT_TAG);
     pango_layout_set_text(wl, ws_text, -1);
 
     int ww, wh;
@@ -437,66 +1159,503 @@ static void draw_card(cairo_t *cr, WindowInfo *win, double x, double y,
     double wy = y + h - badge_h - 10;
 
     /* Badge background — sharp rounded square */
-    cairo_set_source_rgba(cr, bdg_r, bdg_g, bdg_b, bdg_a);
-    draw_rounded_rect(cr, wx, wy, badge_w, badge_h, 4.0);
-    cairo_fill(cr);
+    if (!sprite_draw(cr, pill_sprite(scale, PILL_TAG, selected, badge_h), wx,
+                     wy, badge_w, badge_h)) {
+      cairo_set_source(cr, badge_bg);
+      draw_rounded_rect(cr, wx, wy, badge_w, badge_h, 4.0);
+      cairo_fill(cr);
+    }
 
     /* Badge text — pixel-snapped center */
-    cairo_set_source_rgba(cr, bdt_r, bdt_g, bdt_b, bdt_a);
+    cairo_set_source(cr, badge_text);
     cairo_move_to(cr, (int)(wx + (badge_w - ww) / 2.0),
                       (int)(wy + (badge_h - wh) / 2.0));
     pango_cairo_show_layout(cr, wl);
-    g_object_unref(wl);
-
-    free(ws_text);
   }
 
   cairo_restore(cr);
 }
 
-void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
-  /* Error overlay: measure text dynamically with a temporary Cairo surface.
-   * We create a throwaway 1x1 image surface purely for Pango text metrics,
-   * then derive the exact surface size from the measured pixel bounds. */
-  if (state && state->error_message) {
-    int pad = 32;  /* consistent padding on all sides */
-    int err_font = cfg ? cfg->error_font_size : 13;
-    int hint_font = (err_font * 7 + 5) / 10;  /* ~70% of error font */
-    int wm_font = (hint_font * 8 + 5) / 10;   /* ~80% of hint font */
-    int text_gap = 8;  /* vertical gap between text lines */
-
-    /* Temporary surface for measurement only */
-    cairo_surface_t *tmp_surf =
-        cairo_image_surface_create(CAIRO_FORMAT_ARGB32, 1, 1);
-    cairo_t *tmp_cr = cairo_create(tmp_surf);
-
-    /* Measure the main error text ("⚠  <message>") */
-    char full_msg[512];
-    snprintf(full_msg, sizeof(full_msg), "\xe2\x9a\xa0  %s", state->error_message);
+/* --- Card Raster Cache ---
+ *
+ * Each card is rasterized once per (window id, title, class, group count,
+ * workspace tag, theme generation, scale) and state, then composited as a
+ * tile.  Moving the selection re-blits two cached tiles instead of shaping
+ * every title and clipping every icon again.
+ */
 
-    PangoLayout *msg_layout = create_layout(tmp_cr, err_font);
-    pango_layout_set_text(msg_layout, full_msg, -1);
-    int msg_w, msg_h;
-    pango_layout_get_pixel_size(msg_layout, &msg_w, &msg_h);
-    g_object_unref(msg_layout);
+#define CARD_TAG_MAX 64
+
+typedef struct {
+  uint64_t id;
+  uint64_t title_hash;
+  uint64_t class_hash;
+  int group_count;
+  char tag[CARD_TAG_MAX];
+  unsigned theme_gen;
+  unsigned icon_gen; /* icons_generation() the tiles were drawn at */
+  bool icon_pending; /* A tile shows a placeholder for a loading icon */
+  unsigned icon_wait; /* icons_loaded_generation() it was drawn at */
+  int scale;
+  cairo_surface_t *tile[2]; /* [0] normal, [1] selected; drawn on demand */
+  uint64_t tile_serial[2];  /* Identifies each tile's contents (damage) */
+  bool used;                /* Shown since the last trim */
+} CardEntry;
+
+static CardEntry *card_cache = NULL;
+static int card_cache_count = 0;
+static int card_cache_capacity = 0;
+static uint64_t tile_counter = 0;
+
+/* What the last committed frame showed (see Damage Tracking below) */
+typedef struct {
+  bool valid;         /* False: next frame must be drawn in full */
+  uint32_t phys_w;    /* Buffer size it was drawn for */
+  uint32_t phys_h;
+  int scale;
+  unsigned theme_gen;
+  int count;          /* Cards in the grid */
+  uint64_t *tiles;    /* Tile serial shown at each grid index */
+  int tiles_capacity;
+} Scene;
+
+static Scene scene = {0};
+
+/* Per-card data gathered before drawing a grid frame */
+typedef struct {
+  cairo_surface_t *tile; /* NULL: draw directly (tile allocation failed) */
+  int entry;             /* Index into card_cache, -1 if none */
+  uint64_t serial;
+  double x, y;
+  char tag[CARD_TAG_MAX];
+} FrameCard;
+
+static FrameCard *frame_cards = NULL;
+static int frame_cards_capacity = 0;
+
+static bool frame_cards_reserve(int count) {
+  if (count <= frame_cards_capacity)
+    return true;
+  FrameCard *n = realloc(frame_cards, count * sizeof(FrameCard));
+  if (!n)
+    return false;
+  frame_cards = n;
+  frame_cards_capacity = count;
+  return true;
+}
+
+static void card_entry_drop_tiles(CardEntry *e) {
+  for (int i = 0; i < 2; i++) {
+    if (e->tile[i]) {
+      cairo_surface_destroy(e->tile[i]);
+      e->tile[i] = NULL;
+    }
+  }
+}
+
+/*
+ * Find (or create) the entry for `win`, invalidating its tiles if any part
+ * of the key changed.  `hint` is the card's grid index: the window order
+ * rarely changes between frames, so the entry is usually found there.
+ */
+static CardEntry *card_cache_get(WindowInfo *win, const char *tag, int scale,
+                                 int hint) {
+  CardEntry *e = NULL;
+  if (hint < card_cache_count && card_cache[hint].id == win->id) {
+    e = &card_cache[hint];
+  } else {
+    for (int i = 0; i < card_cache_count; i++) {
+      if (card_cache[i].id == win->id) {
+        e = &card_cache[i];
+        break;
+      }
+    }
+  }
+
+  if (!e) {
+    if (card_cache_count >= card_cache_capacity) {
+      int cap = card_cache_capacity ? card_cache_capacity * 2 : 32;
+      CardEntry *n = realloc(card_cache, cap * sizeof(CardEntry));
+      if (!n)
+        return NULL;
+      card_cache = n;
+      card_cache_capacity = cap;
+    }
+    e = &card_cache[card_cache_count++];
+    memset(e, 0, sizeof(*e));
+    e->id = win->id;
+  }
+
+  uint64_t title_hash = hash64(win->title);
+  uint64_t class_hash = hash64(win->class_name);
+  unsigned icon_gen = icons_generation();
+  if (e->title_hash != title_hash || e->class_hash != class_hash ||
+      e->group_count != win->group_count || strcmp(e->tag, tag) != 0 ||
+      e->theme_gen != theme_generation || e->icon_gen != icon_gen ||
+      e->scale != scale ||
+      (e->icon_pending && e->icon_wait != icons_loaded_generation())) {
+    card_entry_drop_tiles(e);
+    e->title_hash = title_hash;
+    e->class_hash = class_hash;
+    e->group_count = win->group_count;
+    snprintf(e->tag, sizeof(e->tag), "%s", tag);
+    e->theme_gen = theme_generation;
+    e->icon_gen = icon_gen;
+    e->icon_pending = false;
+    e->scale = scale;
+  }
+  e->used = true;
+  return e;
+}
+
+/* Draw one card state into a new tile of physical size (thread-safe given
+ * prepared assets and sprites) */
+static cairo_surface_t *rasterize_card(WindowInfo *win, const char *tag,
+                                       bool selected, int scale,
+                                       const CardAssets *assets) {
+  int m = theme.margin;
+  int w = theme.card_w;
+  int h = theme.card_h;
+
+  cairo_surface_t *tile = cairo_image_surface_create(
+      CAIRO_FORMAT_ARGB32, (w + CARD_STACK_OFFSET + 2 * m) * scale,
+      (h + CARD_STACK_OFFSET + 2 * m) * scale);
+  if (cairo_surface_status(tile) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(tile);
+    return NULL;
+  }
+
+  cairo_t *cr = cairo_create(tile);
+  if (theme.tiles_opaque) {
+    /* Same pixels the panel background leaves under the card */
+    cairo_set_source(cr, theme.pat[PAT_BACKGROUND]);
+    cairo_paint(cr);
+  }
+  cairo_scale(cr, scale, scale);
+  cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
+  draw_card(cr, win, m, m, selected, tag, assets);
+  cairo_destroy(cr);
+  return tile;
+}
+
+/* Composite a tile with its card's top-left corner at (x, y) (logical) */
+static void blit_card(cairo_t *cr, cairo_surface_t *tile, double x, double y,
+                      int scale) {
+  int m = theme.margin;
+  double dx = (x - m) * scale;
+  double dy = (y - m) * scale;
+
+  cairo_save(cr);
+  cairo_identity_matrix(cr);
+  cairo_set_source_surface(cr, tile, dx, dy);
+  if (theme.tiles_opaque) {
+    /* Integer offsets + SOURCE: pixman turns this into row copies */
+    cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
+    cairo_rectangle(cr, dx, dy, cairo_image_surface_get_width(tile),
+                    cairo_image_surface_get_height(tile));
+    cairo_fill(cr);
+  } else {
+    cairo_paint(cr);
+  }
+  cairo_restore(cr);
+}
+
+/* --- Raster Workers ---
+ *
+ * Tiles missing from the cache (first show, a title change, a new output
+ * scale) are drawn by a small pool of threads, one per core up to
+ * RASTER_THREADS_MAX, with the render thread taking jobs too.  Each job
+ * draws into its own tile surface with its own cairo context, and shapes
+ * its text with its own Pango contexts; everything else it reads (theme,
+ * sprites, icons, font descriptions) is prepared on the render thread
+ * first and not modified until all jobs are done.  Idle workers sleep on a
+ * condition variable.
+ */
+
+#define RASTER_THREADS_MAX 8
+#define RASTER_PARALLEL_MIN 4 /* Fewer new tiles are drawn inline */
+
+typedef struct {
+  WindowInfo *win;
+  const char *tag;
+  bool selected;
+  int scale;
+  int entry;              /* Index into card_cache */
+  CardAssets assets;
+  cairo_surface_t *tile;  /* Result; NULL if drawing failed */
+} RasterJob;
+
+typedef struct {
+  pthread_t thread;
+  TextSet text; /* Its private Pango contexts */
+} RasterWorker;
+
+static struct {
+  RasterWorker workers[RASTER_THREADS_MAX - 1];
+  int count;     /* Worker threads running */
+  bool started;  /* Pool start attempted */
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  unsigned generation; /* Bumped for each batch */
+  bool quit;
+  int busy;            /* Workers still on the current batch */
+
+  RasterJob *jobs;
+  int job_count;
+  int job_capacity;
+  int next_job;        /* Claimed with an atomic increment */
+} raster = {
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+    .done = PTHREAD_COND_INITIALIZER,
+};
+
+static cairo_surface_t *rasterize_card(WindowInfo *win, const char *tag,
+                                       bool selected, int scale,
+                                       const CardAssets *assets);
+
+/* Claim and draw jobs until none are left */
+static void raster_drain(void) {
+  int i;
+  while ((i = __atomic_fetch_add(&raster.next_job, 1, __ATOMIC_RELAXED)) <
+         raster.job_count) {
+    RasterJob *job = &raster.jobs[i];
+    job->tile = rasterize_card(job->win, job->tag, job->selected, job->scale,
+                               &job->assets);
+  }
+}
+
+static void *raster_worker_main(void *arg) {
+  RasterWorker *w = arg;
+  text_set = &w->text;
+
+  pthread_mutex_lock(&raster.lock);
+  unsigned seen = raster.generation;
+  for (;;) {
+    while (!raster.quit && raster.generation == seen)
+      pthread_cond_wait(&raster.wake, &raster.lock);
+    if (raster.quit)
+      break;
+    seen = raster.generation;
+    pthread_mutex_unlock(&raster.lock);
+
+    raster_drain();
+
+    pthread_mutex_lock(&raster.lock);
+    if (--raster.busy == 0)
+      pthread_cond_signal(&raster.done);
+  }
+  pthread_mutex_unlock(&raster.lock);
+  return NULL;
+}
+
+/* Threads to draw with: render_threads, or one per core (0 = auto) */
+static int raster_thread_target(void) {
+  int n = cfg ? cfg->render_threads : 0;
+  if (n <= 0) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    n = cores > 0 ? (int)cores : 1;
+  }
+  return n > RASTER_THREADS_MAX ? RASTER_THREADS_MAX : n;
+}
+
+/* Start the workers on first use, each pinned to its own core */
+static void raster_start(void) {
+  raster.started = true;
+  int target = raster_thread_target() - 1; /* The render thread draws too */
+  long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 0; i < target; i++) {
+    RasterWorker *w = &raster.workers[raster.count];
+    memset(&w->text, 0, sizeof(w->text));
+    if (pthread_create(&w->thread, NULL, raster_worker_main, w) != 0) {
+      LOG("Failed to start raster worker %d, continuing with %d", i,
+          raster.count);
+      break;
+    }
+    if (cores > 1) {
+      cpu_set_t set;
+      CPU_ZERO(&set);
+      CPU_SET((i + 1) % cores, &set);
+      pthread_setaffinity_np(w->thread, sizeof(set), &set);
+    }
+    raster.count++;
+  }
+  if (raster.count > 0)
+    LOG("Started %d raster workers", raster.count);
+}
+
+static void raster_stop(void) {
+  if (raster.count > 0) {
+    pthread_mutex_lock(&raster.lock);
+    raster.quit = true;
+    pthread_cond_broadcast(&raster.wake);
+    pthread_mutex_unlock(&raster.lock);
+    for (int i = 0; i < raster.count; i++)
+      pthread_join(raster.workers[i].thread, NULL);
+  }
+  raster_text_sets_free();
+  raster.count = 0;
+  raster.started = false;
+  raster.quit = false;
+
+  free(raster.jobs);
+  raster.jobs = NULL;
+  raster.job_count = 0;
+  raster.job_capacity = 0;
+}
+
+static void raster_text_sets_free(void) {
+  for (int i = 0; i < raster.count; i++)
+    text_set_free(&raster.workers[i].text);
+}
+
+/* Every thread's title cache, for the flushes below.  No raster job may
+ * be running: the workers' caches are theirs while they draw. */
+static TextSet *title_set_at(int i) {
+  if (i == 0)
+    return &main_text_set;
+  if (i == 1)
+    return &render_text_set;
+  return i - 2 < raster.count ? &raster.workers[i - 2].text : NULL;
+}
+
+static void title_cache_free(void) {
+  TextSet *set;
+  for (int i = 0; (set = title_set_at(i)); i++)
+    title_set_clear(set);
+}
+
+/* Forget every title shaped for `window_id`, on any thread */
+static void title_cache_invalidate(uint64_t window_id) {
+  TextSet *set;
+  for (int i = 0; (set = title_set_at(i)); i++)
+    title_set_invalidate(set, window_id);
+}
+
+static RasterJob *raster_add_job(void) {
+  if (raster.job_count >= raster.job_capacity) {
+    int cap = raster.job_capacity ? raster.job_capacity * 2 : 32;
+    RasterJob *n = realloc(raster.jobs, cap * sizeof(RasterJob));
+    if (!n)
+      return NULL;
+    raster.jobs = n;
+    raster.job_capacity = cap;
+  }
+  RasterJob *job = &raster.jobs[raster.job_count++];
+  memset(job, 0, sizeof(*job));
+  return job;
+}
+
+/* Draw every queued job, in parallel when there are enough of them, and
+ * return once all are done.  Returns the number of threads used. */
+static int raster_run(int scale) {
+  if (raster.job_count == 0)
+    return 0;
+
+  if (raster.job_count >= RASTER_PARALLEL_MIN && !raster.started)
+    raster_start();
+  bool parallel = raster.job_count >= RASTER_PARALLEL_MIN && raster.count > 0;
+
+  /* Everything the jobs read from shared state, prepared here; titles
+   * come from the cache of whichever thread draws the job */
+  chrome_prepare(scale);
+  for (int i = 0; i < raster.job_count; i++) {
+    RasterJob *job = &raster.jobs[i];
+    card_assets_get(job->win, scale, &job->assets);
+  }
+
+  int threads = 1;
+  raster.next_job = 0;
+  if (parallel) {
+    chrome_frozen = true;
+    pthread_mutex_lock(&raster.lock);
+    raster.busy = raster.count;
+    raster.generation++;
+    pthread_cond_broadcast(&raster.wake);
+    pthread_mutex_unlock(&raster.lock);
+
+    raster_drain();
+
+    pthread_mutex_lock(&raster.lock);
+    while (raster.busy > 0)
+      pthread_cond_wait(&raster.done, &raster.lock);
+    pthread_mutex_unlock(&raster.lock);
+    chrome_frozen = false;
+    threads = raster.count + 1;
+  } else {
+    raster_drain();
+  }
+
+  for (int i = 0; i < raster.job_count; i++)
+    card_assets_put(&raster.jobs[i].assets);
+  return threads;
+}
+
+/* Drop the tiles of cards not shown since the last trim */
+static void card_cache_trim(void) {
+  int kept = 0;
+  for (int i = 0; i < card_cache_count; i++) {
+    CardEntry *e = &card_cache[i];
+    if (!e->used) {
+      card_entry_drop_tiles(e);
+      continue;
+    }
+    e->used = false;
+    card_cache[kept++] = *e;
+  }
+  if (kept != card_cache_count)
+    LOG("Card cache trimmed: %d -> %d entries", card_cache_count, kept);
+  card_cache_count = kept;
+
+  /* The surface is unmapped on hide: the next frame starts from scratch */
+  scene.valid = false;
+}
+
+static void card_cache_free(void) {
+  for (int i = 0; i < card_cache_count; i++)
+    card_entry_drop_tiles(&card_cache[i]);
+  free(card_cache);
+  card_cache = NULL;
+  card_cache_count = 0;
+  card_cache_capacity = 0;
+
+  free(scene.tiles);
+  memset(&scene, 0, sizeof(scene));
+  free(frame_cards);
+  frame_cards = NULL;
+  frame_cards_capacity = 0;
+}
+
+void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
+  /* Error overlay: measure text dynamically with a temporary Cairo surface.
+   * We create a throwaway 1x1 image surface purely for Pango text metrics,
+   * then derive the exact surface size from the measured pixel bounds. */
+  if (state && state->error_message) {
+    int pad = 32;  /* consistent padding on all sides */
+    int text_gap = 8;  /* vertical gap between text lines */
+
+    /* Measure the main error text ("⚠  <message>") */
+    char full_msg[512];
+    snprintf(full_msg, sizeof(full_msg), "\xe2\x9a\xa0  %s", state->error_message);
+
+    PangoLayout *msg_layout = text_layout(1, FONT_ERROR);
+    pango_layout_set_text(msg_layout, full_msg, -1);
+    int msg_w, msg_h;
+    pango_layout_get_pixel_size(msg_layout, &msg_w, &msg_h);
 
     /* Measure the subtitle ("Press Escape to close.") */
-    PangoLayout *hint_layout = create_layout(tmp_cr, hint_font);
+    PangoLayout *hint_layout = text_layout(1, FONT_HINT);
     pango_layout_set_text(hint_layout, "Press Escape to close.", -1);
     int hint_w, hint_h;
     pango_layout_get_pixel_size(hint_layout, &hint_w, &hint_h);
-    g_object_unref(hint_layout);
 
     /* Measure the watermark ("Snappy-Switcher") */
-    PangoLayout *wm_layout = create_layout(tmp_cr, wm_font);
+    PangoLayout *wm_layout = text_layout(1, FONT_WATERMARK);
     pango_layout_set_text(wm_layout, "Snappy-Switcher", -1);
     int wm_w, wm_h;
     pango_layout_get_pixel_size(wm_layout, &wm_w, &wm_h);
-    g_object_unref(wm_layout);
-
-    /* Destroy temporary Cairo objects — no leaks */
-    cairo_destroy(tmp_cr);
-    cairo_surface_destroy(tmp_surf);
 
     /* Derive surface dimensions from the widest text line */
     int content_w = msg_w;
@@ -514,11 +1673,11 @@ void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
   }
 
   int count = (state && state->count > 0) ? state->count : 1;
-  int w = cfg ? cfg->card_width : 200;
-  int h = cfg ? cfg->card_height : 160;
-  int gap = cfg ? cfg->card_gap : 12;
-  int pad = cfg ? cfg->padding : 32;
-  int cols = cfg ? cfg->max_cols : 5;
+  int w = theme.card_w;
+  int h = theme.card_h;
+  int gap = theme.card_gap;
+  int pad = theme.padding;
+  int cols = theme.max_cols;
 
   if (count < cols)
     cols = count;
@@ -532,107 +1691,487 @@ void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height) {
   if (*height <= 0) *height = 10;
 }
 
-/* --- Buffer Lifecycle Management --- */
+/* --- Buffer Lifecycle Management ---
+ *
+ * All buffers live in one long-lived memfd arena shared with the
+ * compositor through a single wl_shm_pool.  Each ring slot owns a region
+ * of the arena.  The render thread lays the regions out and fills them,
+ * and hands each frame over as an offset, size, stride and format (see
+ * FrameResult); it never issues a Wayland request.  The main thread owns
+ * the pool and the wl_buffers: it resizes the pool after the arena grew,
+ * and keeps a slot's wl_buffer for as long as its layout stays the same,
+ * so a steady-state frame only attaches, damages and commits.  The arena
+ * grows in size classes when a bigger surface no longer fits.  Pools
+ * can't shrink, so regions a slot outgrows are kept on a short free list
+ * for the next resize, and the pages of unused space are handed back to
+ * the kernel.
+ */
 
-#define RENDER_BUFFER_COUNT 2
-static RenderBuffer render_buffers[RENDER_BUFFER_COUNT] = {0};
+#define RENDER_BUFFER_MAX 4 /* Upper bound of the buffer_count setting */
+#define SHM_MIN_CLASS (64 * 1024)
+#define SHM_FREE_MAX 8 /* Abandoned regions remembered for reuse */
 
-/* Called by the compositor when it is done reading a buffer.
- * We destroy the Wayland protocol objects (they're per-commit) but KEEP the
- * backing fd + mmap alive so the next frame can reuse the same memory. */
-static void buffer_release(void *data, struct wl_buffer *wl_buffer) {
-  RenderBuffer *buf = (RenderBuffer *)data;
-  (void)wl_buffer;
+static RenderBuffer render_buffers[RENDER_BUFFER_MAX] = {0};
+
+typedef struct {
+  int offset;
+  int size;
+} ShmRegion;
+
+typedef struct {
+  int fd;
+  void *data;
+  int size;  /* Bytes mapped and shared with the pool */
+  int used;  /* End of the highest region handed out */
+  ShmRegion free[SHM_FREE_MAX]; /* Below `used`, owned by no slot */
+  int free_count;
+} ShmArena;
+
+static ShmArena arena = {.fd = -1}; /* Render thread */
+
+/* Main thread: the arena as the compositor sees it */
+static struct wl_shm_pool *shm_pool = NULL;
+static int shm_pool_size = 0;
+
+/* Slots of the ring in use: the buffer_count setting, clamped */
+static int ring_depth(void) {
+  int n = cfg ? cfg->buffer_count : 2;
+  if (n < 2)
+    return 2;
+  return n > RENDER_BUFFER_MAX ? RENDER_BUFFER_MAX : n;
+}
+
+/* Round up to a size class: four steps per power of two (<= 25% slack) */
+static int shm_size_class(int size) {
+  if (size <= SHM_MIN_CLASS)
+    return SHM_MIN_CLASS;
+  int step = 1;
+  while (step <= size / 8)
+    step <<= 1;
+  return (size + step - 1) / step * step;
+}
+
+/* Point every slot at its region again after the arena moved */
+static void arena_rebase(void) {
+  for (int i = 0; i < RENDER_BUFFER_MAX; i++) {
+    RenderBuffer *buf = &render_buffers[i];
+    buf->data = buf->size ? (char *)arena.data + buf->offset : NULL;
+  }
+}
+
+/* Make the arena at least `size` bytes, creating it on first use */
+static bool arena_reserve(int size) {
+  if (size <= arena.size)
+    return true;
+
+  size = shm_size_class(size);
+  if (arena.fd < 0) {
+    int fd = create_shm_file(size);
+    if (fd < 0)
+      return false;
+    void *data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      return false;
+    }
+    arena.fd = fd;
+    arena.data = data;
+    arena.size = size;
+    LOG("SHM arena created: %d KiB", size / 1024);
+    return true;
+  }
+
+  if (ftruncate(arena.fd, size) < 0)
+    return false;
+  void *data = mremap(arena.data, arena.size, size, MREMAP_MAYMOVE);
+  if (data == MAP_FAILED)
+    return false;
+  arena.data = data;
+  arena.size = size;
+  arena_rebase();
+  LOG("SHM arena grown to %d KiB", size / 1024);
+  return true;
+}
+
+/* Drop the pages behind an unused range; the pool keeps its size and the
+ * range reads back as zeroes when it is used again */
+static void arena_discard(int offset, int size) {
+  if (size > 0)
+    fallocate(arena.fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, offset,
+              size);
+}
+
+/* Take the smallest free region of at least `size` bytes */
+static bool arena_take(int size, ShmRegion *out) {
+  int best = -1;
+  for (int i = 0; i < arena.free_count; i++) {
+    if (arena.free[i].size >= size &&
+        (best < 0 || arena.free[i].size < arena.free[best].size))
+      best = i;
+  }
+  if (best < 0)
+    return false;
+  *out = arena.free[best];
+  arena.free[best] = arena.free[--arena.free_count];
+  return true;
+}
+
+/* Return a region no slot uses any more */
+static void arena_put(int offset, int size) {
+  if (size <= 0)
+    return;
+  arena_discard(offset, size);
+
+  /* At the top: lower `used`, along with free regions that now end there */
+  if (offset + size == arena.used) {
+    arena.used = offset;
+    for (int i = 0; i < arena.free_count;) {
+      if (arena.free[i].offset + arena.free[i].size == arena.used) {
+        arena.used = arena.free[i].offset;
+        arena.free[i] = arena.free[--arena.free_count];
+        i = 0;
+      } else {
+        i++;
+      }
+    }
+    return;
+  }
 
+  /* Full: forget the smallest (reclaimed at the next idle relayout) */
+  int slot = arena.free_count;
+  if (slot == SHM_FREE_MAX) {
+    slot = 0;
+    for (int i = 1; i < SHM_FREE_MAX; i++) {
+      if (arena.free[i].size < arena.free[slot].size)
+        slot = i;
+    }
+    if (arena.free[slot].size >= size)
+      return;
+  } else {
+    arena.free_count++;
+  }
+  arena.free[slot] = (ShmRegion){offset, size};
+}
+
+static void arena_free(void) {
+  if (arena.data)
+    munmap(arena.data, arena.size);
+  if (arena.fd >= 0)
+    close(arena.fd);
+  arena = (ShmArena){.fd = -1};
+}
+
+/* The slot's pixels no longer match any frame (render thread) */
+static void buffer_forget(RenderBuffer *buf) {
+  buf->width = 0;
+  buf->height = 0;
+  buf->frame_serial = 0;
+}
+
+/* Main thread */
+static void buffer_destroy(RenderBuffer *buf) {
   if (buf->buffer) {
     wl_buffer_destroy(buf->buffer);
     buf->buffer = NULL;
   }
-  if (buf->pool) {
-    wl_shm_pool_destroy(buf->pool);
-    buf->pool = NULL;
+}
+
+/* Give `buf` a region of at least `needed` bytes.  With the whole ring
+ * idle the regions are laid out again side by side; otherwise the slot
+ * moves to a free region, or the end of the arena, so in-flight buffers
+ * stay untouched. */
+static bool buffer_region(RenderBuffer *buf, int needed) {
+  bool idle = true;
+  for (int i = 0; i < RENDER_BUFFER_MAX; i++)
+    idle &= !__atomic_load_n(&render_buffers[i].in_use, __ATOMIC_ACQUIRE);
+
+  int ring_size = ring_depth();
+  int cls = shm_size_class(needed);
+  if (idle) {
+    if (!arena_reserve(cls * ring_size))
+      return false;
+    for (int i = 0; i < RENDER_BUFFER_MAX; i++) {
+      RenderBuffer *b = &render_buffers[i];
+      buffer_forget(b); /* Its region moves */
+      b->offset = i < ring_size ? i * cls : 0;
+      b->size = i < ring_size ? cls : 0;
+    }
+    arena.used = cls * ring_size;
+    arena.free_count = 0;
+    arena_discard(arena.used, arena.size - arena.used);
+  } else {
+    /* The old region is idle (the compositor released it): free it first
+     * so that, at the top of the arena, the new one can start there */
+    arena_put(buf->offset, buf->size);
+    buf->size = 0;
+    ShmRegion r;
+    if (!arena_take(cls, &r)) {
+      if (!arena_reserve(arena.used + cls))
+        return false;
+      r = (ShmRegion){arena.used, cls};
+      arena.used += cls;
+    }
+    buf->offset = r.offset;
+    buf->size = r.size;
   }
-  /* fd, data, size, alloc_width, alloc_height are PRESERVED for reuse */
-  buf->in_use = false;
+  arena_rebase();
+  return true;
+}
+
+static void render_thread_ring(void);
+
+/* Called (on the main thread) by the compositor when it is done reading a
+ * buffer.  The wl_buffer stays alive for the next frame of the same
+ * layout; the render thread may be waiting for the slot. */
+static void buffer_release(void *data, struct wl_buffer *wl_buffer) {
+  RenderBuffer *buf = (RenderBuffer *)data;
+  (void)wl_buffer;
+  __atomic_store_n(&buf->in_use, false, __ATOMIC_RELEASE);
+  render_thread_ring();
 }
 
 static const struct wl_buffer_listener buffer_listener = {
     .release = buffer_release,
 };
 
-/* Find a free buffer slot, or NULL if all are in-flight */
+/* Find a free buffer slot with a region for the requested size, or NULL
+ * if all are in-flight (render thread) */
 static RenderBuffer *acquire_buffer(uint32_t phys_w, uint32_t phys_h,
-                                     int stride) {
+                                     int stride, uint32_t format) {
   int needed_size = stride * (int)phys_h;
 
-  for (int i = 0; i < RENDER_BUFFER_COUNT; i++) {
-    RenderBuffer *buf = &render_buffers[i];
-    if (buf->in_use)
-      continue;
+  RenderBuffer *buf = NULL;
+  for (int i = 0; i < ring_depth() && !buf; i++) {
+    if (!__atomic_load_n(&render_buffers[i].in_use, __ATOMIC_ACQUIRE))
+      buf = &render_buffers[i];
+  }
+  if (!buf)
+    return NULL;
 
-    /* Check if existing allocation matches the requested dimensions */
-    if (buf->data && buf->alloc_width == phys_w &&
-        buf->alloc_height == phys_h) {
-      /* Hot path: reuse existing mmap'd region — zero syscalls */
-      return buf;
-    }
+  /* Hot path: same size as last time — zero syscalls */
+  if (buf->width == phys_w && buf->height == phys_h && buf->format == format)
+    return buf;
 
-    /* Dimensions changed (or first use): tear down old allocation */
-    if (buf->data) {
-      munmap(buf->data, buf->size);
-      buf->data = NULL;
-    }
-    if (buf->fd >= 0) {
-      close(buf->fd);
-      buf->fd = -1;
-    }
+  /* Size changed (or first use): stale pixels, maybe a new region */
+  buffer_forget(buf);
+  if (buf->size < needed_size && !buffer_region(buf, needed_size))
+    return NULL;
+  buf->width = phys_w;
+  buf->height = phys_h;
+  buf->format = format;
+  return buf;
+}
 
-    /* Allocate fresh backing memory */
-    int fd = create_shm_file(needed_size);
-    if (fd < 0)
-      return NULL;
 
-    void *data = mmap(NULL, needed_size, PROT_READ | PROT_WRITE,
-                      MAP_SHARED, fd, 0);
-    if (data == MAP_FAILED) {
-      close(fd);
-      return NULL;
-    }
+/* Force-free all buffer slots, the SHM arena and cached tiles (for
+ * shutdown) */
+static void render_thread_close(void);
 
-    buf->fd = fd;
-    buf->data = data;
-    buf->size = needed_size;
-    buf->alloc_width = phys_w;
-    buf->alloc_height = phys_h;
-    return buf;
+void render_cleanup_buffers(void) {
+  render_thread_close();
+  raster_stop();
+  card_cache_free();
+  text_resources_free();
+  chrome_free();
+  theme_free();
+
+  render_forget_surface();
+  for (int i = 0; i < RENDER_BUFFER_MAX; i++) {
+    buffer_destroy(&render_buffers[i]);
+    render_buffers[i] = (RenderBuffer){0};
   }
-  return NULL;
+  if (shm_pool) {
+    wl_shm_pool_destroy(shm_pool);
+    shm_pool = NULL;
+    shm_pool_size = 0;
+  }
+  arena_free();
 }
 
-/* Force-free all buffer slots (for shutdown) */
-void render_cleanup_buffers(void) {
-  for (int i = 0; i < RENDER_BUFFER_COUNT; i++) {
-    RenderBuffer *buf = &render_buffers[i];
-    if (buf->buffer) {
-      wl_buffer_destroy(buf->buffer);
-      buf->buffer = NULL;
-    }
-    if (buf->pool) {
-      wl_shm_pool_destroy(buf->pool);
-      buf->pool = NULL;
-    }
-    if (buf->data) {
-      munmap(buf->data, buf->size);
-      buf->data = NULL;
-    }
-    if (buf->fd >= 0) {
-      close(buf->fd);
-      buf->fd = -1;
+/* --- Frame Pacing ---
+ *
+ * A new frame is only committed once the compositor has signalled
+ * (through wl_surface.frame) that the previous one was used.  State
+ * changes made in between are coalesced into that next frame (see Render
+ * Thread).  Main thread only, apart from `frames_skipped`.
+ */
+
+static struct wl_callback *frame_callback = NULL;
+static unsigned long frames_rendered = 0;
+static unsigned long frames_coalesced = 0; /* Changes folded into a frame */
+static unsigned long frames_skipped = 0;   /* No free buffer (atomic) */
+
+static void frame_done(void *data, struct wl_callback *cb, uint32_t time) {
+  (void)data;
+  (void)time;
+  wl_callback_destroy(cb);
+  frame_callback = NULL;
+}
+
+static const struct wl_callback_listener frame_listener = {
+    .done = frame_done,
+};
+
+void render_reset_pacing(void) {
+  if (frame_callback) {
+    wl_callback_destroy(frame_callback);
+    frame_callback = NULL;
+  }
+}
+
+/* --- Opaque Region ---
+ *
+ * With an opaque background the compositor need not blend anything but
+ * the panel's rounded corners.  The region is surface state, so it is
+ * only sent again when the size or the theme's opacity changes.
+ */
+
+static uint32_t opaque_w = 0, opaque_h = 0; /* Logical size last sent */
+static int opaque_r = -1; /* Corner radius last sent, -1 = none/unset */
+
+static void update_opaque_region(uint32_t w, uint32_t h) {
+  int r = theme.bg_opaque ? theme.panel_radius : -1;
+  if (w == opaque_w && h == opaque_h && r == opaque_r)
+    return;
+  opaque_w = w;
+  opaque_h = h;
+  opaque_r = r;
+
+  if (r < 0 || (int)w <= 2 * r || (int)h <= 2 * r) {
+    wl_surface_set_opaque_region(surface, NULL);
+    return;
+  }
+  struct wl_region *region = wl_compositor_create_region(compositor);
+  if (!region)
+    return;
+  /* A cross: the full-width band between the corners, the full-height
+   * band between them, leaving out the four corner squares */
+  wl_region_add(region, 0, r, w, h - 2 * r);
+  if (r > 0)
+    wl_region_add(region, r, 0, w - 2 * r, h);
+  wl_surface_set_opaque_region(surface, region);
+  wl_region_destroy(region);
+}
+
+void render_forget_surface(void) {
+  render_reset_pacing();
+  opaque_w = opaque_h = 0;
+  opaque_r = -1;
+}
+
+void render_log_stats(void) {
+  LOG("Frames: %lu rendered, %lu coalesced, %lu skipped", frames_rendered,
+      frames_coalesced, __atomic_load_n(&frames_skipped, __ATOMIC_RELAXED));
+}
+
+/* --- Damage Tracking ---
+ *
+ * A selection move changes two cards, so only their rects are redrawn and
+ * reported to the compositor.  With several buffers in the ring, the one
+ * we draw into is `age` frames old: before drawing, the areas damaged by
+ * the frames it missed are copied forward from the newest buffer.
+ */
+
+#define DAMAGE_HISTORY 4   /* Frames of damage kept (>= buffer ring size) */
+#define DAMAGE_MAX_RECTS 8 /* More than this and a full redraw is cheaper */
+
+typedef struct {
+  int x, y, w, h; /* Physical pixels */
+} DamageRect;
+
+typedef struct {
+  uint64_t serial; /* Frame this entry describes */
+  bool full;       /* Whole buffer redrawn */
+  int count;
+  DamageRect rects[DAMAGE_MAX_RECTS];
+} FrameDamage;
+
+static FrameDamage damage_history[DAMAGE_HISTORY];
+static uint64_t frame_counter = 0;
+static RenderBuffer *last_buffer = NULL; /* Holds the newest frame */
+
+/* Add a rect (clipped to the buffer); false if the list is full */
+static bool damage_add(FrameDamage *d, int x, int y, int w, int h,
+                       uint32_t buf_w, uint32_t buf_h) {
+  if (x < 0) {
+    w += x;
+    x = 0;
+  }
+  if (y < 0) {
+    h += y;
+    y = 0;
+  }
+  if (x + w > (int)buf_w)
+    w = (int)buf_w - x;
+  if (y + h > (int)buf_h)
+    h = (int)buf_h - y;
+  if (w <= 0 || h <= 0)
+    return true;
+  if (d->count >= DAMAGE_MAX_RECTS)
+    return false;
+  d->rects[d->count++] = (DamageRect){x, y, w, h};
+  return true;
+}
+
+/*
+ * Bring `dst` up to date with the previous frame by copying the rects that
+ * changed since it was last drawn.  Returns false if that is not possible
+ * (buffer too old, a full redraw in between, size change...).
+ */
+static bool copy_forward(RenderBuffer *dst, uint64_t serial, int stride) {
+  if (dst->frame_serial == 0 || !last_buffer ||
+      last_buffer->frame_serial != serial - 1)
+    return false;
+  if (dst == last_buffer)
+    return true; /* Already holds the previous frame */
+  if (!last_buffer->data || last_buffer->width != dst->width ||
+      last_buffer->height != dst->height)
+    return false;
+
+  uint64_t age = serial - dst->frame_serial;
+  if (age > DAMAGE_HISTORY)
+    return false;
+  for (uint64_t f = dst->frame_serial + 1; f < serial; f++) {
+    FrameDamage *d = &damage_history[f % DAMAGE_HISTORY];
+    if (d->serial != f || d->full)
+      return false;
+  }
+
+  for (uint64_t f = dst->frame_serial + 1; f < serial; f++) {
+    FrameDamage *d = &damage_history[f % DAMAGE_HISTORY];
+    for (int i = 0; i < d->count; i++) {
+      DamageRect *r = &d->rects[i];
+      for (int row = r->y; row < r->y + r->h; row++) {
+        size_t off = (size_t)row * stride + (size_t)r->x * 4;
+        memcpy((char *)dst->data + off, (char *)last_buffer->data + off,
+               (size_t)r->w * 4);
+      }
     }
-    buf->in_use = false;
-    buf->alloc_width = 0;
-    buf->alloc_height = 0;
   }
+  return true;
+}
+
+/* Remember what this frame showed, for the next frame's damage */
+static void scene_record(bool grid, uint32_t phys_w, uint32_t phys_h,
+                         int scale, int count) {
+  scene.valid = false;
+  if (!grid)
+    return;
+  if (count > scene.tiles_capacity) {
+    uint64_t *n = realloc(scene.tiles, count * sizeof(uint64_t));
+    if (!n)
+      return;
+    scene.tiles = n;
+    scene.tiles_capacity = count;
+  }
+  for (int i = 0; i < count; i++)
+    scene.tiles[i] = frame_cards[i].serial;
+  scene.valid = true;
+  scene.phys_w = phys_w;
+  scene.phys_h = phys_h;
+  scene.scale = scale;
+  scene.theme_gen = theme_generation;
+  scene.count = count;
 }
 
 /* --- Error Overlay ---
@@ -640,25 +2179,19 @@ void render_cleanup_buffers(void) {
  * The surface has already been sized dynamically by calculate_dimensions(). */
 static void draw_error_overlay(cairo_t *cr, int width, int height,
                                const char *msg) {
-  int radius = cfg ? cfg->card_radius : 12;
+  int radius = theme.card_radius;
   double stroke_w = 2.5;
   /* Inset the stroke by half its width so it doesn't get clipped at edges */
   double inset = stroke_w / 2.0;
 
   /* Card background — fills the entire Wayland surface */
-  double bg_r, bg_g, bg_b, bg_a;
-  if (cfg)
-    color_to_rgba(cfg->card_bg, &bg_r, &bg_g, &bg_b, &bg_a);
-  else {
-    bg_r = 0.19; bg_g = 0.19; bg_b = 0.26; bg_a = 1.0;
-  }
-  cairo_set_source_rgba(cr, bg_r, bg_g, bg_b, bg_a);
+  cairo_set_source(cr, theme.pat[PAT_CARD_BG]);
   draw_rounded_rect(cr, 0, 0, width, height, radius);
   cairo_fill(cr);
 
   /* Warning border — clean outer perimeter stroke */
   cairo_set_line_width(cr, stroke_w);
-  cairo_set_source_rgba(cr, 0.91, 0.30, 0.24, 0.9);  /* #E84C3D */
+  cairo_set_source(cr, theme.pat[PAT_ERROR_BORDER]);
   draw_rounded_rect(cr, inset, inset,
                     width - stroke_w, height - stroke_w, radius);
   cairo_stroke(cr);
@@ -667,34 +2200,24 @@ static void draw_error_overlay(cairo_t *cr, int width, int height,
   int text_gap = 8;
 
   /* ⚠ indicator + error text */
-  double txt_r, txt_g, txt_b, txt_a;
-  if (cfg)
-    color_to_rgba(cfg->text_color, &txt_r, &txt_g, &txt_b, &txt_a);
-  else {
-    txt_r = 0.80; txt_g = 0.84; txt_b = 0.96; txt_a = 1.0;
-  }
-
   char full_msg[512];
   snprintf(full_msg, sizeof(full_msg), "\xe2\x9a\xa0  %s", msg);
 
-  int err_font = cfg ? cfg->error_font_size : 13;
-  PangoLayout *layout = create_layout(cr, err_font);
+  PangoLayout *layout = layout_for(cr, FONT_ERROR);
   pango_layout_set_text(layout, full_msg, -1);
 
   int lw, lh;
   pango_layout_get_pixel_size(layout, &lw, &lh);
 
   /* Subtitle: "Press Escape to close." */
-  int hint_font = (err_font * 7 + 5) / 10;  /* ~70% of error font */
-  PangoLayout *hint = create_layout(cr, hint_font);
+  PangoLayout *hint = layout_for(cr, FONT_HINT);
   pango_layout_set_text(hint, "Press Escape to close.", -1);
 
   int hw, hh;
   pango_layout_get_pixel_size(hint, &hw, &hh);
 
   /* Watermark: "Snappy-Switcher" */
-  int wm_font = (hint_font * 8 + 5) / 10;  /* ~80% of hint font */
-  PangoLayout *watermark = create_layout(cr, wm_font);
+  PangoLayout *watermark = layout_for(cr, FONT_WATERMARK);
   pango_layout_set_text(watermark, "Snappy-Switcher", -1);
 
   int wmw, wmh;
@@ -705,59 +2228,193 @@ static void draw_error_overlay(cairo_t *cr, int width, int height,
   int block_y = (height - total_text_h) / 2;
 
   /* Error text — pixel-snapped center */
-  cairo_set_source_rgba(cr, txt_r, txt_g, txt_b, txt_a);
+  cairo_set_source(cr, theme.pat[PAT_TEXT]);
   cairo_move_to(cr, (int)((width - lw) / 2.0), (int)block_y);
   pango_cairo_show_layout(cr, layout);
-  g_object_unref(layout);
 
   /* Subtitle — pixel-snapped center, below error text */
-  double sub_r, sub_g, sub_b, sub_a;
-  if (cfg)
-    color_to_rgba(cfg->subtext_color, &sub_r, &sub_g, &sub_b, &sub_a);
-  else {
-    sub_r = 0.65; sub_g = 0.68; sub_b = 0.78; sub_a = 1.0;
-  }
-
-  cairo_set_source_rgba(cr, sub_r, sub_g, sub_b, sub_a * 0.7);
+  cairo_set_source(cr, theme.pat[PAT_ERROR_HINT]);
   cairo_move_to(cr, (int)((width - hw) / 2.0), (int)(block_y + lh + text_gap));
   pango_cairo_show_layout(cr, hint);
-  g_object_unref(hint);
 
   /* Watermark — dimmed, pixel-snapped center, below subtitle */
-  cairo_set_source_rgba(cr, sub_r, sub_g, sub_b, sub_a * 0.4);
+  cairo_set_source(cr, theme.pat[PAT_ERROR_WATERMARK]);
   cairo_move_to(cr, (int)((width - wmw) / 2.0),
                     (int)(block_y + lh + text_gap + hh + text_gap));
   pango_cairo_show_layout(cr, watermark);
-  g_object_unref(watermark);
 }
 
-void render_ui(AppState *state, uint32_t logical_width, uint32_t logical_height,
-               int scale) {
+/* What draw_frame() hands to the main thread for presentation */
+typedef struct {
+  RenderBuffer *buf;      /* NULL: the frame could not be drawn */
+  FrameDamage damage;
+  uint32_t width, height; /* Logical surface size */
+  int changes;            /* needs_render count the frame carries */
+  int arena_fd;           /* Where the pixels are, for the wl_buffer */
+  int arena_size;
+  int offset;
+  int stride;
+  uint32_t phys_width, phys_height;
+  uint32_t format;
+} FrameResult;
+
+/* Draw `state` into a free ring buffer (render thread).  Returns false if
+ * none is free or allocation failed; nothing is touched on the surface. */
+static bool draw_frame(AppState *state, uint32_t logical_width,
+                       uint32_t logical_height, int scale, FrameResult *out) {
   uint32_t phys_width = logical_width * scale;
   uint32_t phys_height = logical_height * scale;
 
-  int stride = cairo_format_stride_for_width(CAIRO_FORMAT_ARGB32, phys_width);
-
-  /* Acquire a free buffer slot (reuses persistent mmap when possible) */
-  RenderBuffer *rbuf = acquire_buffer(phys_width, phys_height, stride);
-  if (!rbuf) {
-    LOG("All render buffers in use or allocation failed, skipping frame");
-    return;
-  }
+  /* Fully opaque themes skip the alpha channel (XRGB), so the compositor
+   * can treat the buffer as opaque whatever it holds */
+  cairo_format_t cformat =
+      theme.opaque ? CAIRO_FORMAT_RGB24 : CAIRO_FORMAT_ARGB32;
+  uint32_t format =
+      theme.opaque ? WL_SHM_FORMAT_XRGB8888 : WL_SHM_FORMAT_ARGB8888;
+  int stride = cairo_format_stride_for_width(cformat, phys_width);
+
+  /* Acquire a free buffer slot (reuses its region when possible) */
+  RenderBuffer *rbuf = acquire_buffer(phys_width, phys_height, stride, format);
+  if (!rbuf)
+    return false;
 
   void *data = rbuf->data;
-  int size = rbuf->size;
-  int fd = rbuf->fd;
 
-  /* Clear pixel data */
-  memset(data, 0, size);
+  uint64_t serial = ++frame_counter;
+  FrameDamage *damage = &damage_history[serial % DAMAGE_HISTORY];
+  damage->serial = serial;
+  damage->full = true;
+  damage->count = 0;
+
+  /* --- Grid: fetch (or rasterize) every card's tile up front --- */
+  bool grid = state && !state->error_message && state->count > 0 &&
+              frame_cards_reserve(state->count);
+  bool tiles_ok = grid;
+  if (grid) {
+    int cw = theme.card_w;
+    int ch = theme.card_h;
+    int gap = theme.card_gap;
+    int pad = theme.padding;
+    int max_cols = theme.max_cols;
+
+    int cols = (state->count < max_cols) ? state->count : max_cols;
+    int rows = (state->count + max_cols - 1) / max_cols;
+
+    int grid_w = (cols * cw) + ((cols - 1) * gap);
+    int grid_h = (rows * ch) + ((rows - 1) * gap);
+
+    /* Whole pixels, so tiles land on the physical pixel grid */
+    double start_x = (int)((logical_width - grid_w) / 2.0);
+    double start_y = (int)((logical_height - grid_h) / 2.0);
+    if (start_x < pad)
+      start_x = pad;
+    if (start_y < pad)
+      start_y = pad;
+
+    /* Zero the workspace letter tracker for this render pass */
+    letter_tracker_init(&g_letter_tracker);
+
+    /* Look up every card; queue the tiles that must be drawn */
+    raster.job_count = 0;
+    for (int i = 0; i < state->count; i++) {
+      FrameCard *fc = &frame_cards[i];
+      bool selected = i == state->selected_index;
+      fc->x = start_x + (i % max_cols) * (cw + gap);
+      fc->y = start_y + (i / max_cols) * (ch + gap);
+      fc->tag[0] = '\0';
+      if (theme.show_workspace_badge)
+        format_workspace_tag(&state->windows[i], &g_letter_tracker, fc->tag,
+                             sizeof(fc->tag));
+
+      CardEntry *e = card_cache_get(&state->windows[i], fc->tag, scale, i);
+      fc->entry = e ? (int)(e - card_cache) : -1;
+      if (e && !e->tile[selected]) {
+        RasterJob *job = raster_add_job();
+        if (job)
+          *job = (RasterJob){.win = &state->windows[i],
+                             .tag = fc->tag,
+                             .selected = selected,
+                             .scale = scale,
+                             .entry = fc->entry};
+      }
+    }
+
+    int drawn = raster.job_count;
+    if (drawn > 0) {
+      struct timespec t0, t1;
+      clock_gettime(CLOCK_MONOTONIC, &t0);
+      int threads = raster_run(scale);
+      clock_gettime(CLOCK_MONOTONIC, &t1);
+      LOG("Rasterized %d of %d cards in %.2f ms (%d thread%s)", drawn,
+          state->count,
+          (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6,
+          threads, threads == 1 ? "" : "s");
+
+      for (int j = 0; j < drawn; j++) {
+        RasterJob *job = &raster.jobs[j];
+        CardEntry *e = &card_cache[job->entry];
+        e->tile[job->selected] = job->tile;
+        if (job->tile)
+          e->tile_serial[job->selected] = ++tile_counter;
+        if (job->assets.icon_pending) {
+          e->icon_pending = true;
+          e->icon_wait = job->assets.icon_gen;
+        }
+      }
+    }
+
+    for (int i = 0; i < state->count; i++) {
+      FrameCard *fc = &frame_cards[i];
+      bool selected = i == state->selected_index;
+      CardEntry *e = fc->entry >= 0 ? &card_cache[fc->entry] : NULL;
+      fc->tile = e ? e->tile[selected] : NULL;
+      fc->serial = fc->tile ? e->tile_serial[selected] : 0;
+      if (!fc->tile)
+        tiles_ok = false;
+    }
+  }
+
+  /* --- Partial redraw: only cards whose tile changed since last frame --- */
+  bool partial = tiles_ok && theme.tiles_opaque && scene.valid &&
+                 scene.phys_w == phys_width && scene.phys_h == phys_height &&
+                 scene.scale == scale && scene.theme_gen == theme_generation &&
+                 scene.count == state->count;
+  if (partial) {
+    damage->full = false;
+    int m = theme.margin;
+    for (int i = 0; i < state->count && partial; i++) {
+      FrameCard *fc = &frame_cards[i];
+      if (fc->serial == scene.tiles[i])
+        continue;
+      partial = damage_add(damage, (int)((fc->x - m) * scale),
+                           (int)((fc->y - m) * scale),
+                           cairo_image_surface_get_width(fc->tile),
+                           cairo_image_surface_get_height(fc->tile),
+                           phys_width, phys_height);
+    }
+    if (partial)
+      partial = copy_forward(rbuf, serial, stride);
+    if (!partial) {
+      damage->full = true;
+      damage->count = 0;
+    }
+  }
 
   cairo_surface_t *surf = cairo_image_surface_create_for_data(
-      data, CAIRO_FORMAT_ARGB32, phys_width, phys_height, stride);
+      data, cformat, phys_width, phys_height, stride);
   cairo_t *cr = cairo_create(surf);
   cairo_scale(cr, scale, scale);
   cairo_set_antialias(cr, CAIRO_ANTIALIAS_BEST);
 
+  if (partial) {
+    for (int i = 0; i < state->count; i++) {
+      if (frame_cards[i].serial != scene.tiles[i])
+        blit_card(cr, frame_cards[i].tile, frame_cards[i].x, frame_cards[i].y,
+                  scale);
+    }
+    goto commit;
+  }
+
   /* CRITICAL FIX 2: Source Clear */
   cairo_set_operator(cr, CAIRO_OPERATOR_SOURCE);
   cairo_set_source_rgba(cr, 0, 0, 0, 0);
@@ -765,28 +2422,16 @@ void render_ui(AppState *state, uint32_t logical_width, uint32_t logical_height,
   cairo_set_operator(cr, CAIRO_OPERATOR_OVER);
 
   /* Background */
-  double r, g, b, a;
-  if (cfg)
-    color_to_rgba(cfg->background, &r, &g, &b, &a);
-  else {
-    r = 0.1;
-    g = 0.1;
-    b = 0.2;
-    a = 0.95;
-  }
-
-  cairo_set_source_rgba(cr, r, g, b, a);
-  int rad = cfg ? cfg->card_radius : 12;
-  draw_rounded_rect(cr, 0, 0, logical_width, logical_height, rad + 4);
+  cairo_set_source(cr, theme.pat[PAT_BACKGROUND]);
+  draw_rounded_rect(cr, 0, 0, logical_width, logical_height,
+                    theme.panel_radius);
   cairo_fill(cr);
 
   /* Border */
-  if (cfg)
-    color_to_rgba(cfg->border_color, &r, &g, &b, &a);
-  cairo_set_source_rgba(cr, r, g, b, 0.3);
+  cairo_set_source(cr, theme.pat[PAT_PANEL_BORDER]);
   cairo_set_line_width(cr, 1);
   draw_rounded_rect(cr, 0.5, 0.5, logical_width - 1, logical_height - 1,
-                    rad + 4);
+                    theme.panel_radius);
   cairo_stroke(cr);
 
   /* --- Error overlay short-circuit --- */
@@ -796,75 +2441,461 @@ void render_ui(AppState *state, uint32_t logical_width, uint32_t logical_height,
   }
 
   /* Content */
-  if (!state || state->count == 0) {
-    PangoLayout *msg = create_layout(cr, 16);
-    pango_layout_set_text(msg, "No windows", -1);
+  if (grid) {
+    for (int i = 0; i < state->count; i++) {
+      FrameCard *fc = &frame_cards[i];
+      if (fc->tile)
+        blit_card(cr, fc->tile, fc->x, fc->y, scale);
+      else {
+        CardAssets assets;
+        card_assets_get(&state->windows[i], scale, &assets);
+        draw_card(cr, &state->windows[i], fc->x, fc->y,
+                  i == state->selected_index, fc->tag, &assets);
+        card_assets_put(&assets);
+      }
+    }
+  } else {
+    const char *text = (!state || state->count == 0) ? "No windows"
+                                                     : "Out of memory";
+    PangoLayout *msg = layout_for(cr, FONT_MESSAGE);
+    pango_layout_set_text(msg, text, -1);
     int mw, mh;
     pango_layout_get_pixel_size(msg, &mw, &mh);
 
-    if (cfg)
-      color_to_rgba(cfg->text_color, &r, &g, &b, &a);
-    cairo_set_source_rgba(cr, r, g, b, 0.5);
+    cairo_set_source(cr, theme.pat[PAT_MESSAGE]);
     cairo_move_to(cr, (int)((logical_width - mw) / 2.0), (int)((logical_height - mh) / 2.0));
     pango_cairo_show_layout(cr, msg);
-    g_object_unref(msg);
-  } else {
-    int cw = cfg ? cfg->card_width : 200;
-    int ch = cfg ? cfg->card_height : 160;
-    int gap = cfg ? cfg->card_gap : 12;
-    int pad = cfg ? cfg->padding : 32;
-    int max_cols = cfg ? cfg->max_cols : 5;
+  }
 
-    int cols = (state->count < max_cols) ? state->count : max_cols;
-    int rows = (state->count + max_cols - 1) / max_cols;
+commit:;
+  int layouts = __atomic_exchange_n(&layouts_created, 0, __ATOMIC_RELAXED);
+  int contexts = __atomic_exchange_n(&contexts_created, 0, __ATOMIC_RELAXED);
+#ifdef SNAPPY_DEBUG
+  LOG("Frame %lu: created %d Pango layouts, %d contexts", (unsigned long)serial,
+      layouts, contexts);
+#else
+  if (layouts || contexts)
+    LOG("Created %d Pango layouts, %d contexts", layouts, contexts);
+#endif
 
-    int grid_w = (cols * cw) + ((cols - 1) * gap);
-    int grid_h = (rows * ch) + ((rows - 1) * gap);
+  /* Snapshot what this buffer now holds, for the next frames' damage */
+  scene_record(grid && tiles_ok, phys_width, phys_height, scale,
+               grid ? state->count : 0);
+  rbuf->frame_serial = serial;
+  last_buffer = rbuf;
+
+  /* Reserved until the main thread has attached (or discarded) it */
+  __atomic_store_n(&rbuf->in_use, true, __ATOMIC_RELEASE);
+  out->buf = rbuf;
+  out->damage = *damage;
+  out->width = logical_width;
+  out->height = logical_height;
+  out->arena_fd = arena.fd;
+  out->arena_size = arena.size;
+  out->offset = rbuf->offset;
+  out->stride = stride;
+  out->phys_width = phys_width;
+  out->phys_height = phys_height;
+  out->format = format;
 
-    double start_x = (logical_width - grid_w) / 2.0;
-    double start_y = (logical_height - grid_h) / 2.0;
-    if (start_x < pad)
-      start_x = pad;
-    if (start_y < pad)
-      start_y = pad;
+  /* Clean up Cairo objects (these are CPU-side only, safe to free now) */
+  cairo_destroy(cr);
+  cairo_surface_destroy(surf);
+  return true;
+}
 
-    /* Zero the workspace letter tracker for this render pass */
-    letter_tracker_init(&g_letter_tracker);
+/* --- Render Thread ---
+ *
+ * Frames are drawn off the event loop, so key presses and IPC commands are
+ * handled at the same latency however long a frame takes.  The main
+ * thread posts a private copy of the AppState to a single-slot mailbox,
+ * replacing any copy the render thread has not picked up yet (the newest
+ * state always wins).  The render thread draws it into a free ring buffer
+ * and hands the result back through a second slot plus an eventfd; the
+ * main thread only attaches and commits it, paced by frame callbacks.
+ *
+ * Requests that touch the render thread's caches (trim, title changes)
+ * are queued under `lock` and applied by the render thread between
+ * frames.  Wayland objects (surface, pool, buffers) are only ever touched
+ * by the main thread.
+ */
 
-    for (int i = 0; i < state->count; i++) {
-      int r = i / max_cols;
-      int c = i % max_cols;
-      double x = start_x + c * (cw + gap);
-      double y = start_y + r * (ch + gap);
-      draw_card(cr, &state->windows[i], x, y, i == state->selected_index);
+#define RENDER_TITLE_QUEUE 32 /* Queued title changes before a full flush */
+
+typedef struct {
+  AppState state; /* Owns copies of the windows and their strings */
+  uint32_t width, height;
+  int scale;
+  int changes;    /* needs_render count folded into this snapshot */
+} RenderSnapshot;
+
+static struct {
+  pthread_t thread;
+  bool running;
+  int event_fd;              /* Readable when `result` is ready */
+
+  RenderSnapshot *mailbox;   /* Exchanged atomically */
+  FrameResult result;        /* Owned by the render thread until ready */
+  bool result_ready;         /* Atomic handover of `result` */
+
+  pthread_mutex_t lock;      /* Doorbell and the requests below */
+  pthread_cond_t wake;
+  bool quit;
+  bool trim;
+  bool reset_scene;
+  bool flush_titles;
+  uint64_t titles[RENDER_TITLE_QUEUE];
+  int title_count;
+} rt = {
+    .event_fd = -1,
+    .lock = PTHREAD_MUTEX_INITIALIZER,
+    .wake = PTHREAD_COND_INITIALIZER,
+};
+
+static void snapshot_free(RenderSnapshot *snap) {
+  if (snap) {
+    app_state_free(&snap->state);
+    free(snap);
+  }
+}
+
+/* Deep copy of what draw_frame() reads from `src` */
+static RenderSnapshot *snapshot_create(const AppState *src, uint32_t width,
+                                       uint32_t height, int scale) {
+  RenderSnapshot *snap = calloc(1, sizeof(*snap));
+  if (!snap)
+    return NULL;
+  app_state_init(&snap->state);
+  snap->width = width;
+  snap->height = height;
+  snap->scale = scale;
+  snap->changes = src->needs_render;
+
+  size_t bytes = 0;
+  for (int i = 0; i < src->count; i++) {
+    const WindowInfo *w = &src->windows[i];
+    bytes += (w->title ? strlen(w->title) + 1 : 0) +
+             (w->class_name ? strlen(w->class_name) + 1 : 0) +
+             (w->workspace_name ? strlen(w->workspace_name) + 1 : 0);
+  }
+  if (bytes > 0 && app_state_reserve_strings(&snap->state, bytes) < 0)
+    goto fail;
+
+  AppState *dst = &snap->state;
+  for (int i = 0; i < src->count; i++) {
+    WindowInfo w = src->windows[i];
+    w.title = w.title ? app_state_intern(dst, w.title) : NULL;
+    w.class_name = w.class_name ? app_state_intern(dst, w.class_name) : NULL;
+    w.workspace_name =
+        w.workspace_name ? app_state_intern(dst, w.workspace_name) : NULL;
+    w.member_offset = -1; /* Group members are not drawn */
+    if (app_state_add(dst, &w) < 0)
+      goto fail;
+  }
+  dst->selected_index = src->selected_index;
+  dst->cols = src->cols;
+  if (src->error_message) {
+    dst->error_message = strdup(src->error_message);
+    if (!dst->error_message)
+      goto fail;
+  }
+  return snap;
+
+fail:
+  snapshot_free(snap);
+  return NULL;
+}
+
+/* Any ring slot not held by the compositor or an undelivered result */
+static bool ring_has_free(void) {
+  for (int i = 0; i < ring_depth(); i++) {
+    if (!__atomic_load_n(&render_buffers[i].in_use, __ATOMIC_ACQUIRE))
+      return true;
+  }
+  return false;
+}
+
+static void render_thread_ring(void) {
+  pthread_mutex_lock(&rt.lock);
+  pthread_cond_signal(&rt.wake);
+  pthread_mutex_unlock(&rt.lock);
+}
+
+static bool render_can_draw(void) {
+  return __atomic_load_n(&rt.mailbox, __ATOMIC_ACQUIRE) &&
+         !__atomic_load_n(&rt.result_ready, __ATOMIC_ACQUIRE) &&
+         ring_has_free();
+}
+
+/* Draw the newest snapshot, if any, and hand the frame to the main thread */
+static void render_thread_draw(void) {
+  RenderSnapshot *snap = __atomic_exchange_n(&rt.mailbox, NULL,
+                                             __ATOMIC_ACQ_REL);
+  if (!snap)
+    return;
+
+  FrameResult res = {0};
+  if (!draw_frame(&snap->state, snap->width, snap->height, snap->scale,
+                  &res)) {
+    if (!ring_has_free()) {
+      /* Every buffer is in flight: keep the snapshot for the next release,
+       * unless the main thread has posted a newer one meanwhile */
+      __atomic_add_fetch(&frames_skipped, 1, __ATOMIC_RELAXED);
+      RenderSnapshot *expected = NULL;
+      if (!__atomic_compare_exchange_n(&rt.mailbox, &expected, snap, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        snapshot_free(snap);
+      return;
     }
+    LOG("Frame allocation failed");
+    /* Deliver the failure: the main thread asks for the state again */
   }
+  res.changes = snap->changes;
+  snapshot_free(snap);
+
+  rt.result = res;
+  __atomic_store_n(&rt.result_ready, true, __ATOMIC_RELEASE);
+  uint64_t one = 1;
+  if (write(rt.event_fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+    LOG("Render eventfd write failed: %s", strerror(errno));
+}
+
+static void *render_thread_main(void *arg) {
+  (void)arg;
+  text_set = &render_text_set;
+
+  pthread_mutex_lock(&rt.lock);
+  for (;;) {
+    while (!rt.quit && !rt.trim && !rt.reset_scene && !rt.flush_titles &&
+           rt.title_count == 0 && !render_can_draw())
+      pthread_cond_wait(&rt.wake, &rt.lock);
+    if (rt.quit)
+      break;
+
+    bool trim = rt.trim, reset = rt.reset_scene, flush = rt.flush_titles;
+    uint64_t titles[RENDER_TITLE_QUEUE];
+    int title_count = rt.title_count;
+    memcpy(titles, rt.titles, title_count * sizeof(uint64_t));
+    rt.trim = rt.reset_scene = rt.flush_titles = false;
+    rt.title_count = 0;
+    pthread_mutex_unlock(&rt.lock);
+
+    if (flush)
+      title_cache_free();
+    for (int i = 0; i < title_count; i++)
+      title_cache_invalidate(titles[i]);
+    if (trim)
+      card_cache_trim();
+    if (reset)
+      scene.valid = false;
+    if (render_can_draw())
+      render_thread_draw();
+
+    pthread_mutex_lock(&rt.lock);
+  }
+  pthread_mutex_unlock(&rt.lock);
+  return NULL;
+}
 
-commit:
-  /* --- Wayland Commit with proper buffer lifecycle --- */
-  struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, size);
-  struct wl_buffer *buffer = wl_shm_pool_create_buffer(
-      pool, 0, phys_width, phys_height, stride, WL_SHM_FORMAT_ARGB8888);
+static bool render_thread_start(void) {
+  if (rt.running)
+    return true;
+  if (rt.event_fd < 0) {
+    rt.event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (rt.event_fd < 0) {
+      LOG("eventfd failed: %s", strerror(errno));
+      return false;
+    }
+  }
+  rt.quit = false;
+  if (pthread_create(&rt.thread, NULL, render_thread_main, NULL) != 0) {
+    LOG("Failed to start the render thread");
+    return false;
+  }
+  rt.running = true;
+  return true;
+}
 
-  /* Populate the RenderBuffer slot BEFORE committing */
-  rbuf->buffer = buffer;
-  rbuf->pool = pool;
-  rbuf->data = data;
-  rbuf->size = size;
-  rbuf->fd = fd;
-  rbuf->in_use = true;
+/* Join the render thread; its caches then belong to the main thread */
+static void render_thread_stop(void) {
+  if (!rt.running)
+    return;
+  pthread_mutex_lock(&rt.lock);
+  rt.quit = true;
+  pthread_cond_signal(&rt.wake);
+  pthread_mutex_unlock(&rt.lock);
+  pthread_join(rt.thread, NULL);
+  rt.running = false;
+
+  snapshot_free(__atomic_exchange_n(&rt.mailbox, NULL, __ATOMIC_ACQ_REL));
+  if (rt.result_ready && rt.result.buf)
+    __atomic_store_n(&rt.result.buf->in_use, false, __ATOMIC_RELEASE);
+  rt.result_ready = false;
+
+  /* Apply what it had not got to yet */
+  if (rt.flush_titles)
+    title_cache_free();
+  for (int i = 0; i < rt.title_count; i++)
+    title_cache_invalidate(rt.titles[i]);
+  if (rt.trim)
+    card_cache_trim();
+  rt.trim = rt.reset_scene = rt.flush_titles = false;
+  rt.title_count = 0;
+  scene.valid = false;
+}
 
-  /* Listen for the compositor's release event */
-  wl_buffer_add_listener(buffer, &buffer_listener, rbuf);
+static void render_thread_close(void) {
+  render_thread_stop();
+  if (rt.event_fd >= 0) {
+    close(rt.event_fd);
+    rt.event_fd = -1;
+  }
+}
 
-  wl_surface_attach(surface, buffer, 0, 0);
-  wl_surface_damage_buffer(surface, 0, 0, phys_width, phys_height);
-  wl_surface_commit(surface);
+bool render_submit(AppState *state, uint32_t width, uint32_t height,
+                   int scale) {
+  if (!render_thread_start())
+    return false;
+  RenderSnapshot *snap = snapshot_create(state, width, height, scale);
+  if (!snap) {
+    LOG("Out of memory copying the state for the render thread");
+    return false;
+  }
 
-  /* Clean up Cairo objects (these are CPU-side only, safe to free now) */
-  cairo_destroy(cr);
-  cairo_surface_destroy(surf);
+  RenderSnapshot *old =
+      __atomic_exchange_n(&rt.mailbox, snap, __ATOMIC_ACQ_REL);
+  if (old) {
+    /* Not drawn yet: its changes are carried by the newer snapshot */
+    frames_coalesced += old->changes;
+    snapshot_free(old);
+  }
+  render_thread_ring();
+  return true;
+}
+
+int render_get_event_fd(void) { return rt.event_fd; }
+
+/* The wl_buffer showing `res` (main thread).  The pool is created on first
+ * use and grown after the arena was; the slot's wl_buffer is replaced when
+ * its layout changed.  The old one is idle: the slot was free when the
+ * frame was drawn.  Returns NULL if the buffer could not be created. */
+static struct wl_buffer *present_buffer(const FrameResult *res) {
+  RenderBuffer *buf = res->buf;
+  if (!shm_pool) {
+    shm_pool = wl_shm_create_pool(shm, res->arena_fd, res->arena_size);
+    if (!shm_pool)
+      return NULL;
+    shm_pool_size = res->arena_size;
+  } else if (res->arena_size > shm_pool_size) {
+    wl_shm_pool_resize(shm_pool, res->arena_size);
+    shm_pool_size = res->arena_size;
+  }
+
+  if (buf->buffer && buf->buffer_offset == res->offset &&
+      buf->buffer_stride == res->stride &&
+      buf->buffer_width == res->phys_width &&
+      buf->buffer_height == res->phys_height &&
+      buf->buffer_format == res->format)
+    return buf->buffer;
+
+  buffer_destroy(buf);
+  buf->buffer = wl_shm_pool_create_buffer(shm_pool, res->offset,
+                                          res->phys_width, res->phys_height,
+                                          res->stride, res->format);
+  if (!buf->buffer)
+    return NULL;
+  wl_buffer_add_listener(buf->buffer, &buffer_listener, buf);
+  buf->buffer_offset = res->offset;
+  buf->buffer_stride = res->stride;
+  buf->buffer_width = res->phys_width;
+  buf->buffer_height = res->phys_height;
+  buf->buffer_format = res->format;
+  return buf->buffer;
+}
+
+void render_present(AppState *state, bool visible) {
+  uint64_t count;
+  if (rt.event_fd >= 0 && read(rt.event_fd, &count, sizeof(count)) < 0 &&
+      errno != EAGAIN)
+    LOG("Render eventfd read failed: %s", strerror(errno));
+
+  if (!__atomic_load_n(&rt.result_ready, __ATOMIC_ACQUIRE))
+    return;
+  if (visible && frame_callback)
+    return; /* Held until the compositor wants the next frame */
+
+  FrameResult res = rt.result;
+  __atomic_store_n(&rt.result_ready, false, __ATOMIC_RELEASE);
+
+  struct wl_buffer *wl_buf = NULL;
+  if (res.buf && visible && surface) {
+    wl_buf = present_buffer(&res);
+    if (!wl_buf) {
+      LOG("wl_buffer creation failed");
+      state->needs_render += res.changes > 0 ? res.changes : 1;
+    }
+  }
+
+  if (!res.buf) {
+    state->needs_render += res.changes > 0 ? res.changes : 1;
+  } else if (!wl_buf) {
+    /* Hidden meanwhile (or no wl_buffer): the compositor never saw this
+     * frame, so the next one must not be drawn as a diff against it */
+    __atomic_store_n(&res.buf->in_use, false, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&rt.lock);
+    rt.reset_scene = true;
+    pthread_mutex_unlock(&rt.lock);
+  } else {
+    frames_rendered++;
+    if (res.changes > 1)
+      frames_coalesced += res.changes - 1;
+
+    update_opaque_region(res.width, res.height);
+    render_reset_pacing();
+    frame_callback = wl_surface_frame(surface);
+    wl_callback_add_listener(frame_callback, &frame_listener, NULL);
+
+    wl_surface_attach(surface, wl_buf, 0, 0);
+    if (res.damage.full) {
+      wl_surface_damage_buffer(surface, 0, 0, res.phys_width,
+                               res.phys_height);
+    } else {
+      for (int i = 0; i < res.damage.count; i++)
+        wl_surface_damage_buffer(surface, res.damage.rects[i].x,
+                                 res.damage.rects[i].y, res.damage.rects[i].w,
+                                 res.damage.rects[i].h);
+    }
+    wl_surface_commit(surface);
+  }
+  render_thread_ring(); /* The result slot is free again */
+}
+
+void render_invalidate_title(uint64_t window_id) {
+  if (!rt.running) {
+    title_cache_invalidate(window_id);
+    return;
+  }
+  pthread_mutex_lock(&rt.lock);
+  if (rt.title_count < RENDER_TITLE_QUEUE)
+    rt.titles[rt.title_count++] = window_id;
+  else
+    rt.flush_titles = true;
+  pthread_cond_signal(&rt.wake);
+  pthread_mutex_unlock(&rt.lock);
+}
 
-  /* NOTE: buffer, pool, fd, and data are NOT freed here.
-   * They will be freed in buffer_release() when the compositor is done. */
+void render_trim_cache(void) {
+  /* A frame not drawn yet is not wanted any more either */
+  RenderSnapshot *old = __atomic_exchange_n(&rt.mailbox, NULL,
+                                            __ATOMIC_ACQ_REL);
+  snapshot_free(old);
+
+  if (!rt.running) {
+    card_cache_trim();
+    return;
+  }
+  pthread_mutex_lock(&rt.lock);
+  rt.trim = true;
+  pthread_cond_signal(&rt.wake);
+  pthread_mutex_unlock(&rt.lock);
 }
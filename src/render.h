@@ -9,6 +9,7 @@
 #include <wayland-client.h>
 
 /* Shared Wayland objects needed for rendering */
+extern struct wl_compositor *compositor;
 extern struct wl_shm *shm;
 extern struct wl_surface *surface;
 
@@ -18,13 +19,42 @@ void render_set_config(Config *config);
 /* Calculate optimal window dimensions based on window count */
 void calculate_dimensions(AppState *state, uint32_t *width, uint32_t *height);
 
-/* Render the window switcher UI */
-void render_ui(AppState *state, uint32_t width, uint32_t height, int scale);
+/* Hand a copy of `state` to the render thread, replacing any copy it has
+ * not started drawing. Returns false if that failed (keep needs_render) */
+bool render_submit(AppState *state, uint32_t width, uint32_t height,
+                   int scale);
+
+/* Attach and commit the frame the render thread finished, once the frame
+ * callback allows it (or drop it if not `visible`). Bumps
+ * state->needs_render if the frame could not be drawn. Call every loop
+ * iteration */
+void render_present(AppState *state, bool visible);
+
+/* Readable when a rendered frame is waiting for render_present()
+ * (-1 before the first render_submit()) */
+int render_get_event_fd(void);
+
+/* Forget a pending frame callback (call when the surface is hidden or
+ * destroyed, as it may never fire) */
+void render_reset_pacing(void);
+
+/* Forget all per-surface state (call before destroying the surface) */
+void render_forget_surface(void);
+
+/* Log the rendered / coalesced / skipped frame counters */
+void render_log_stats(void);
 
 /* Create a shared memory file for Wayland buffers */
 int create_shm_file(off_t size);
 
-/* Free any in-flight render buffers (call during shutdown) */
+/* Forget the shaped title of a window whose title changed */
+void render_invalidate_title(uint64_t window_id);
+
+/* Drop cached card tiles not shown since the last trim and any frame not
+ * drawn yet (call on hide) */
+void render_trim_cache(void);
+
+/* Free any in-flight render buffers and cached tiles (call during shutdown) */
 void render_cleanup_buffers(void);
 
 #endif /* RENDER_H */
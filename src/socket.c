@@ -123,7 +123,8 @@ void cleanup_server(int srv_fd) {
 }
 
 /* Client: Send command to daemon */
-int send_command(const char *cmd) {
+/* Connect to the daemon and write `cmd`; returns the socket or -1 */
+static int connect_and_send(const char *cmd) {
   int sock = socket(AF_UNIX, SOCK_STREAM, 0);
   if (sock < 0) {
     LOG("Failed to create client socket: %s", strerror(errno));
@@ -156,7 +157,39 @@ int send_command(const char *cmd) {
     }
     total += (size_t)written;
   }
+  return sock;
+}
+
+int send_command(const char *cmd) {
+  int sock = connect_and_send(cmd);
+  if (sock < 0)
+    return -1;
+  close(sock);
+  return 0;
+}
 
+/* Send `cmd` and read the daemon's reply until it closes the connection */
+int send_command_reply(const char *cmd, char *reply, size_t reply_len) {
+  int sock = connect_and_send(cmd);
+  if (sock < 0)
+    return -1;
+  shutdown(sock, SHUT_WR);
+
+  size_t total = 0;
+  while (total + 1 < reply_len) {
+    ssize_t n = read(sock, reply + total, reply_len - 1 - total);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n < 0) {
+      LOG("Failed to read reply: %s", strerror(errno));
+      close(sock);
+      return -1;
+    }
+    if (n == 0)
+      break;
+    total += (size_t)n;
+  }
+  reply[total] = '\0';
   close(sock);
   return 0;
 }
@@ -3,6 +3,7 @@
 #define SOCKET_H
 
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Compute the runtime socket path.
  * Uses $XDG_RUNTIME_DIR/snappy-switcher.sock when available,
@@ -17,6 +18,7 @@ const char *get_socket_path(void);
 #define CMD_TOGGLE "TOGGLE"
 #define CMD_HIDE "HIDE"
 #define CMD_QUIT "QUIT"
+#define CMD_STATS "STATS" /* Replies with "key value" lines */
 
 /* Server functions (daemon) */
 int init_server(void);
@@ -27,6 +29,9 @@ int get_server_fd(void);
 /* Client functions */
 int send_command(const char *cmd);
 
+/* Send a command that replies; the reply is NUL-terminated in `reply` */
+int send_command_reply(const char *cmd, char *reply, size_t reply_len);
+
 /* Check if daemon is running */
 bool is_daemon_running(void);
 
@@ -6,11 +6,13 @@
 #include "config.h"
 #include "data.h"
 #include <errno.h>
+#include <inttypes.h>
 #include <poll.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 #include <wayland-client-protocol.h>
 #include <wayland-client.h>
@@ -19,26 +21,18 @@
 
 #define LOG(fmt, ...) fprintf(stderr, "[WLR] " fmt "\n", ##__VA_ARGS__)
 
-static char *wlr_safe_strdup(const char *str) {
-  char *dup = strdup(str ? str : "");
-  if (!dup) {
-    static char empty[] = "";
-    return empty;
-  }
-  return dup;
-}
-
 typedef struct WindowNode WindowNode;
 
 struct WindowNode {
   struct zwlr_foreign_toplevel_handle_v1 *handle;
   char *title;
   char *app_id;
-  char *identifier;
+  uint64_t id; /* Monotonic handle id, never reused */
   int state;
   int is_active;
   int is_minimized;
   uint64_t activation_serial; /* window activation serial */
+  WindowNode *prev;
   WindowNode *next;
 };
 
@@ -47,39 +41,59 @@ typedef struct {
   struct wl_registry *registry;
   struct zwlr_foreign_toplevel_manager_v1 *manager;
   struct wl_seat *seat;
-  WindowNode *windows;
+  WindowNode *windows;        /* MRU order: activated windows first */
+  WindowNode *activated_tail; /* Last ever-activated window (NULL if none);
+                                 never-activated windows follow it */
   int window_count;
   int initialized;
   int needs_refresh;
   uint64_t activation_counter; /* global activation counter */
+  uint64_t next_id;            /* last handle id handed out */
 } WlrBackendState;
 
 static WlrBackendState backend_state = {0};
 
-// move window to the front of the activation history list
+// unlink a window from the activation history list in O(1)
+static void list_unlink(WindowNode *window) {
+  if (window->prev)
+    window->prev->next = window->next;
+  else
+    backend_state.windows = window->next;
+  if (window->next)
+    window->next->prev = window->prev;
+  window->prev = window->next = NULL;
+}
+
+// insert a window after `after` (NULL = at the head)
+static void list_insert_after(WindowNode *window, WindowNode *after) {
+  window->prev = after;
+  window->next = after ? after->next : backend_state.windows;
+  if (window->next)
+    window->next->prev = window;
+  if (after)
+    after->next = window;
+  else
+    backend_state.windows = window;
+}
+
+// move window to the front of the activation history list. the list is
+// kept in display order at all times, so snapshots never need sorting.
 static void move_window_to_front(WindowNode *window) {
-  if (!window || !backend_state.windows || window == backend_state.windows) {
+  if (!window || !backend_state.windows) {
     return;
   }
 
-  // remove window from the list
-  WindowNode **prev = &backend_state.windows;
-  WindowNode *curr = backend_state.windows;
-
-  while (curr) {
-    if (curr == window) {
-      *prev = curr->next;
-      break;
-    }
-    prev = &curr->next;
-    curr = curr->next;
+  if (window != backend_state.windows) {
+    // the node before the tail is activated too, so it becomes the tail
+    if (window == backend_state.activated_tail)
+      backend_state.activated_tail = window->prev;
+    list_unlink(window);
+    list_insert_after(window, NULL);
   }
+  if (!backend_state.activated_tail)
+    backend_state.activated_tail = window;
 
-  // insert window to the front of the list
-  window->next = backend_state.windows;
-  backend_state.windows = window;
-
-  // update activation serial (smaller numbers mean more recently activated)
+  // update activation serial (larger numbers mean more recently activated)
   backend_state.activation_counter++;
   window->activation_serial = backend_state.activation_counter;
 }
@@ -209,25 +223,16 @@ toplevel_handle_closed(void *data,
 
   LOG("Window closed: %s", window->title);
 
-  WindowNode **prev = &backend_state.windows;
-  WindowNode *curr = backend_state.windows;
-
-  while (curr) {
-    if (curr == window) {
-      *prev = curr->next;
-      backend_state.window_count--;
-      break;
-    }
-    prev = &curr->next;
-    curr = curr->next;
-  }
+  if (window == backend_state.activated_tail)
+    backend_state.activated_tail = window->prev;
+  list_unlink(window);
+  backend_state.window_count--;
 
   if (window->handle) {
     zwlr_foreign_toplevel_handle_v1_destroy(window->handle);
   }
   free(window->title);
   free(window->app_id);
-  free(window->identifier);
   free(window);
 
   backend_state.needs_refresh = 1;
@@ -272,16 +277,13 @@ manager_handle_toplevel(void *data,
 
   memset(window, 0, sizeof(WindowNode));
   window->handle = toplevel;
-  window->identifier = malloc(64);
-  if (window->identifier) {
-    snprintf(window->identifier, 64, "wlr-%p", toplevel);
-  }
+  window->id = ++backend_state.next_id;
 
   // initial activation serial is 0 (0 means never activated)
   window->activation_serial = 0;
 
-  window->next = backend_state.windows;
-  backend_state.windows = window;
+  // never activated yet: newest first, after all activated windows
+  list_insert_after(window, backend_state.activated_tail);
   backend_state.window_count++;
 
   zwlr_foreign_toplevel_handle_v1_add_listener(toplevel, &toplevel_listener,
@@ -315,11 +317,11 @@ static void cleanup_windows(void) {
     }
     free(curr->title);
     free(curr->app_id);
-    free(curr->identifier);
     free(curr);
     curr = next;
   }
   backend_state.windows = NULL;
+  backend_state.activated_tail = NULL;
   backend_state.window_count = 0;
   backend_state.activation_counter = 0;
 }
@@ -371,13 +373,13 @@ int wlr_backend_init(void) {
   int counter = 0;
   WindowNode *curr = backend_state.windows;
   while (curr) {
-    if (curr->is_active) {
+    WindowNode *next = curr->next;
+    if (curr->is_active && curr->activation_serial == 0) {
       // current active window should be in front
-      backend_state.activation_counter++;
-      curr->activation_serial = backend_state.activation_counter;
+      move_window_to_front(curr);
       counter++;
     }
-    curr = curr->next;
+    curr = next;
   }
 
   LOG("WLR backend initialized with %d windows (%d active)",
@@ -420,14 +422,6 @@ void wlr_backend_cleanup(void) {
 }
 
 
-static int wlr_compare_focus(const void *a, const void *b) {
-  const WindowInfo *wa = (const WindowInfo *)a;
-  const WindowInfo *wb = (const WindowInfo *)b;
-  if (wa->focus_history_id < wb->focus_history_id) return -1;
-  if (wa->focus_history_id > wb->focus_history_id) return 1;
-  return 0;
-}
-
 int wlr_get_windows(AppState *state, Config *config, bool is_linear) {
   (void)config;
   (void)is_linear;  /* WLR backend has no workspace-based sorting */
@@ -466,9 +460,19 @@ int wlr_get_windows(AppState *state, Config *config, bool is_linear) {
     return 0;
   }
 
-  // sort windows by activation order
-  // the list is already sorted by activation order (most recently activated
-  // first)
+  // size the snapshot's string arena up front (see app_state_intern)
+  size_t bytes = 0;
+  for (WindowNode *n = backend_state.windows; n; n = n->next) {
+    bytes += strlen(n->title ? n->title : "Untitled") +
+             strlen(n->app_id ? n->app_id : "unknown") + 3;
+  }
+  if (app_state_reserve_strings(state, bytes) < 0) {
+    LOG("Failed to allocate window strings");
+    return -1;
+  }
+
+  // the list is kept in activation order (most recently activated first),
+  // so no sorting is needed here
   WindowNode *curr = backend_state.windows;
   int index = 0;
 
@@ -480,32 +484,21 @@ int wlr_get_windows(AppState *state, Config *config, bool is_linear) {
       continue;
     }
 
-    info.address = wlr_safe_strdup(curr->identifier);
-    info.title = wlr_safe_strdup(curr->title ? curr->title : "Untitled");
-    info.class_name = wlr_safe_strdup(curr->app_id ? curr->app_id : "unknown");
+    info.id = curr->id;
+    info.title = app_state_intern(state, curr->title ? curr->title : "Untitled");
+    info.class_name =
+        app_state_intern(state, curr->app_id ? curr->app_id : "unknown");
     info.workspace_id = 0;
-    info.workspace_name = wlr_safe_strdup("");
-
-    // use activation serial as focus_history_id
-    // activation serial is larger for more recently activated
-    // for windows that have never been activated, give them a very large value
-    // to ensure they are at the end
-    if (curr->activation_serial == 0) {
-      info.focus_history_id = 10000 + index;
-    } else {
-      // activation serial is smaller for more recently activated (because we
-      // want the most recently activated at the front) use the maximum value
-      // minus the serial number to achieve this
-      info.focus_history_id = 1000 - curr->activation_serial;
-    }
+    info.workspace_name = app_state_intern(state, "");
 
+    // the list is maintained in MRU order, so the position is the rank
+    info.focus_history_id = state->count;
     info.is_active = curr->is_active;
     info.is_floating = 0;
     info.group_count = 1;
-    info.focus_history_id = curr->is_active ? 0 : info.focus_history_id;
+    info.member_offset = -1;
 
     if (app_state_add(state, &info) < 0) {
-      window_info_free(&info);
       LOG("Failed to add window to AppState");
     } else {
       LOG("Added window %d: %s (%s), activation_serial: %lu", index, info.title,
@@ -516,27 +509,21 @@ int wlr_get_windows(AppState *state, Config *config, bool is_linear) {
     index++;
   }
 
-  // sort windows by focus_history_id (smaller numbers mean more recently
-  // activated)
-  if (state->count > 1) {
-    qsort(state->windows, state->count, sizeof(WindowInfo), wlr_compare_focus);
-  }
-
   LOG("Successfully processed %d windows", state->count);
   return 0;
 }
 
-void wlr_activate_window(const char *identifier) {
-  if (!backend_state.initialized || !identifier) {
-    LOG("Cannot activate window: not initialized or identifier NULL");
+void wlr_activate_window(uint64_t id, const struct timespec *started) {
+  if (!backend_state.initialized || !id) {
+    LOG("Cannot activate window: not initialized or id 0");
     return;
   }
 
-  LOG("Activating window: %s", identifier);
+  LOG("Activating window: %" PRIu64, id);
 
   WindowNode *curr = backend_state.windows;
   while (curr) {
-    if (curr->identifier && strcmp(curr->identifier, identifier) == 0) {
+    if (curr->id == id) {
       LOG("Found window to activate: %s", curr->title);
 
       // update activation history: move window to the front
@@ -548,14 +535,23 @@ void wlr_activate_window(const char *identifier) {
         zwlr_foreign_toplevel_handle_v1_activate(curr->handle,
                                                  backend_state.seat);
         wl_display_flush(backend_state.display);
-        LOG("Window activation sent");
+        /* The protocol has no acknowledgement: time up to the flush */
+        if (started) {
+          struct timespec now;
+          clock_gettime(CLOCK_MONOTONIC, &now);
+          LOG("Switch sent in %.2f ms",
+              (now.tv_sec - started->tv_sec) * 1e3 +
+                  (now.tv_nsec - started->tv_nsec) / 1e6);
+        } else {
+          LOG("Window activation sent");
+        }
       }
       return;
     }
     curr = curr->next;
   }
 
-  LOG("Window not found: %s", identifier);
+  LOG("Window not found: %" PRIu64, id);
 }
 
 const char *wlr_get_name(void) { return "wlr"; }
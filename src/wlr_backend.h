@@ -15,7 +15,7 @@ void wlr_backend_cleanup(void);
 int wlr_get_windows(AppState *state, Config *config, bool is_linear);
 
 /* Activate window via wlr protocol */
-void wlr_activate_window(const char *identifier);
+void wlr_activate_window(uint64_t id, const struct timespec *started);
 
 /* Get backend name */
 const char *wlr_get_name(void);